@@ -0,0 +1,120 @@
+#pragma once
+
+#include "reader.hpp"
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <utility>
+
+namespace ma {
+/**
+ * @addtogroup Reader
+ * @{
+ */
+
+namespace detail {
+/* environment of the innermost AmbientScope on this thread */
+template <typename Env> const std::shared_ptr<const Env>*& ambientSlot() {
+  static thread_local const std::shared_ptr<const Env>* current = nullptr;
+  return current;
+}
+}  // namespace detail
+
+/**
+ * Makes an environment ambient on the current thread for its lifetime.
+ *
+ * Scopes nest, the innermost one wins; they must be destroyed in reverse
+ * order of construction, which holds for local variables.
+ *
+ * Example
+ * -------
+ * ~~~
+ * AmbientScope<Services> scope(std::make_shared<const Services>(...));
+ * PropagatingExecutor<Services, ThreadPool> executor(pool);
+ * executor.execute([]() { runAmbient(handleRequest()); });
+ * ~~~
+ */
+template <typename Env> class AmbientScope {
+ public:
+  explicit AmbientScope(std::shared_ptr<const Env> env)
+      : env_(std::move(env)), previous_(detail::ambientSlot<Env>()) {
+    detail::ambientSlot<Env>() = &env_;
+  }
+
+  AmbientScope(const AmbientScope&) = delete;
+  AmbientScope& operator=(const AmbientScope&) = delete;
+
+  ~AmbientScope() {
+    assert(detail::ambientSlot<Env>() == &env_);
+    detail::ambientSlot<Env>() = previous_;
+  }
+
+ private:
+  const std::shared_ptr<const Env> env_;
+  const std::shared_ptr<const Env>* const previous_;
+};
+
+/**
+ * @return The ambient environment of type `Env` of the current thread, null
+ * outside of any AmbientScope.
+ */
+template <typename Env> const std::shared_ptr<const Env>& ambient() {
+  static const std::shared_ptr<const Env> none;
+  const auto* current = detail::ambientSlot<Env>();
+  return current ? *current : none;
+}
+
+/**
+ * Runs a reader with the ambient environment.
+ *
+ * Requires an AmbientScope for `Env` on the current thread.
+ */
+template <typename Env, typename R> R runAmbient(const Reader<Env, R>& reader) {
+  const auto& env = ambient<Env>();
+  assert(env && "runAmbient outside of an AmbientScope");
+  return reader.run(*env);
+}
+
+/**
+ * Executor running functions within the ambient environment of their
+ * submitter.
+ *
+ * `execute` captures the ambient `Env` of the calling thread, sharing it
+ * rather than copying it, and reinstates it around the function on the
+ * thread of the wrapped executor. Functions submitted outside of any scope
+ * are passed on unchanged.
+ *
+ * Wrappers nest to propagate several environment types.
+ */
+template <typename Env, typename Executor> class PropagatingExecutor {
+ public:
+  /**
+   * @param ex Executor, must outlive this.
+   */
+  explicit PropagatingExecutor(Executor& ex) : ex_(ex) {}
+
+  void execute(std::function<void()> f) {
+    const auto& env = ambient<Env>();
+    if (!env) {
+      ex_.execute(std::move(f));
+      return;
+    }
+    ex_.execute([env, f = std::move(f)]() {
+      AmbientScope<Env> scope(env);
+      f();
+    });
+  }
+
+ private:
+  Executor& ex_;
+};
+
+/**
+ * @return PropagatingExecutor for `Env` wrapping `ex`.
+ */
+template <typename Env, typename Executor>
+PropagatingExecutor<Env, Executor> propagating(Executor& ex) {
+  return PropagatingExecutor<Env, Executor>(ex);
+}
+// @}
+}  // namespace ma
@@ -0,0 +1,459 @@
+#pragma once
+
+#include "maybe.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace ma {
+/**
+ * @addtogroup Maybe
+ * @{
+ */
+
+/*
+ * Compare and swap of two adjacent words, if the target has one: through the
+ * builtin where the compiler inlines it, by cmpxchg16b on any other x86-64.
+ */
+#if defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)
+#define MARJORAM_HAS_DOUBLE_WORD_CAS 1
+#elif defined(__x86_64__) && defined(__GNUC__)
+#define MARJORAM_HAS_DOUBLE_WORD_CAS 1
+#define MARJORAM_CMPXCHG16B 1
+#endif
+
+namespace detail {
+template <typename T> Maybe<T> fromBytes(const void* bytes) {
+  typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  std::memcpy(&storage, bytes, sizeof(T));
+  return *reinterpret_cast<const T*>(&storage);
+}
+
+/**
+ * Slot for types smaller than a word: the value and a presence byte are
+ * packed into a single atomic word, all operations are single instructions.
+ */
+template <typename T> class PackedSlot {
+ public:
+  Maybe<T> load() const {
+    return unpack(word_.load(std::memory_order_acquire));
+  }
+
+  void store(const Maybe<T>& m) {
+    word_.store(pack(m), std::memory_order_release);
+  }
+
+  Maybe<T> exchange(const Maybe<T>& m) {
+    return unpack(word_.exchange(pack(m), std::memory_order_acq_rel));
+  }
+
+  bool compareAndSet(const Maybe<T>& expected, const Maybe<T>& desired) {
+    std::uint64_t word = pack(expected);
+    return word_.compare_exchange_strong(word, pack(desired),
+                                         std::memory_order_acq_rel,
+                                         std::memory_order_acquire);
+  }
+
+  bool isLockFree() const { return word_.is_lock_free(); }
+
+  static constexpr bool alwaysLockFree = ATOMIC_LLONG_LOCK_FREE == 2;
+
+ private:
+  /* Nothing is all zeros, Just has its last byte set */
+  static std::uint64_t pack(const Maybe<T>& m) {
+    if (m.isNothing()) {
+      return 0;
+    }
+    unsigned char bytes[sizeof(std::uint64_t)] = {};
+    std::memcpy(bytes, &m.get(), sizeof(T));
+    bytes[sizeof(bytes) - 1] = 1;
+    std::uint64_t word;
+    std::memcpy(&word, bytes, sizeof(word));
+    return word;
+  }
+
+  static Maybe<T> unpack(std::uint64_t word) {
+    if (word == 0) {
+      return Nothing;
+    }
+    return fromBytes<T>(&word);
+  }
+
+  std::atomic<std::uint64_t> word_{0};
+};
+
+#ifdef MARJORAM_HAS_DOUBLE_WORD_CAS
+/**
+ * Replaces the two words at `target`, aligned to 16 bytes, by `desired` if
+ * they equal `expected`, otherwise loads them into `expected`.
+ */
+inline bool casDoubleWord(std::atomic<std::uint64_t>* target,
+                          std::uint64_t (&expected)[2],
+                          const std::uint64_t (&desired)[2]) {
+#ifdef MARJORAM_CMPXCHG16B
+  struct alignas(16) DoubleWord {
+    std::uint64_t words[2];
+  };
+  bool replaced;
+  __asm__ __volatile__("lock cmpxchg16b %1\n\tsete %0"
+                       : "=q"(replaced),
+                         "+m"(*reinterpret_cast<DoubleWord*>(target)),
+                         "+a"(expected[0]), "+d"(expected[1])
+                       : "b"(desired[0]), "c"(desired[1])
+                       : "memory", "cc");
+  return replaced;
+#else
+  __extension__ using Word = unsigned __int128;
+  Word e;
+  Word d;
+  std::memcpy(&e, expected, sizeof(e));
+  std::memcpy(&d, desired, sizeof(d));
+  const Word seen =
+      __sync_val_compare_and_swap(reinterpret_cast<Word*>(target), e, d);
+  if (seen == e) {
+    return true;
+  }
+  std::memcpy(expected, &seen, sizeof(seen));
+  return false;
+#endif
+}
+
+/**
+ * Slot for word sized types: the value and a tag word, holding presence and
+ * a version, are replaced together by a double word compare and swap.
+ *
+ * Readers load both words and check that the tag did not change meanwhile;
+ * as every write is a single instruction bumping the version, they only
+ * retry if another operation completed, all operations are lock free.
+ */
+template <typename T> class DoubleWordSlot {
+ public:
+  DoubleWordSlot() {
+    words_[value].store(0, std::memory_order_relaxed);
+    words_[tag].store(0, std::memory_order_relaxed);
+  }
+
+  Maybe<T> load() const {
+    Words current;
+    read(current);
+    return unpack(current);
+  }
+
+  void store(const Maybe<T>& m) { static_cast<void>(exchange(m)); }
+
+  Maybe<T> exchange(const Maybe<T>& m) {
+    Words current;
+    read(current);
+    while (!replace(current, m)) {
+    }
+    return unpack(current);
+  }
+
+  bool compareAndSet(const Maybe<T>& expected, const Maybe<T>& desired) {
+    Words current;
+    read(current);
+    do {
+      if (bool(current[tag] & present) != expected.isJust() ||
+          (expected.isJust() && current[value] != pack(expected.get()))) {
+        return false;
+      }
+    } while (!replace(current, desired));
+    return true;
+  }
+
+  bool isLockFree() const { return true; }
+
+  static constexpr bool alwaysLockFree = true;
+
+ private:
+  using Words = std::uint64_t[2];
+
+  static const std::size_t value = 0;
+  static const std::size_t tag = 1;
+  /* low bit of the tag, the version is incremented by `step` */
+  static const std::uint64_t present = 1;
+  static const std::uint64_t step = 2;
+
+  static std::uint64_t pack(const T& t) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, &t, sizeof(T));
+    return word;
+  }
+
+  static Maybe<T> unpack(const Words& words) {
+    if (!(words[tag] & present)) {
+      return Nothing;
+    }
+    return fromBytes<T>(&words[value]);
+  }
+
+  void read(Words& words) const {
+    words[tag] = words_[tag].load(std::memory_order_acquire);
+    while (true) {
+      words[value] = words_[value].load(std::memory_order_acquire);
+      const std::uint64_t again = words_[tag].load(std::memory_order_relaxed);
+      if (again == words[tag]) {
+        return;
+      }
+      words[tag] = again;
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+  }
+
+  /* on failure, loads the current words into `current` */
+  bool replace(Words& current, const Maybe<T>& m) {
+    const Words desired = {
+        m.isJust() ? pack(m.get()) : 0,
+        ((current[tag] & ~present) + step) | (m.isJust() ? present : 0)};
+    return casDoubleWord(words_, current, desired);
+  }
+
+  alignas(16) std::atomic<std::uint64_t> words_[2];
+};
+#endif
+
+/**
+ * Slot for larger types, guarded by a sequence lock: readers copy the value
+ * optimistically and retry if a writer interfered, writers exclude each other
+ * by spinning on the sequence number.
+ */
+template <typename T> class SeqlockSlot {
+ public:
+  SeqlockSlot() {
+    for (auto& word : data_) {
+      word.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  Maybe<T> load() const {
+    while (true) {
+      const std::uint64_t seq = seq_.load(std::memory_order_acquire);
+      if (seq & writing) {
+        std::this_thread::yield();
+        continue;
+      }
+      if (!(seq & present)) {
+        return Nothing;
+      }
+      Words words;
+      read(words);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == seq) {
+        return fromBytes<T>(words);
+      }
+    }
+  }
+
+  void store(const Maybe<T>& m) {
+    const std::uint64_t seq = lock();
+    write(m);
+    unlock(seq, m.isJust());
+  }
+
+  Maybe<T> exchange(const Maybe<T>& m) {
+    const std::uint64_t seq = lock();
+    if (!(seq & present)) {
+      if (m.isNothing()) {
+        /* nothing changes, readers need not retry */
+        seq_.store(seq, std::memory_order_release);
+        return Nothing;
+      }
+      write(m);
+      unlock(seq, true);
+      return Nothing;
+    }
+    Words words;
+    read(words);
+    write(m);
+    unlock(seq, m.isJust());
+    return fromBytes<T>(words);
+  }
+
+  bool compareAndSet(const Maybe<T>& expected, const Maybe<T>& desired) {
+    const std::uint64_t seq = lock();
+    bool equal = expected.isJust() == bool(seq & present);
+    if (equal && expected.isJust()) {
+      Words current;
+      Words wanted;
+      read(current);
+      pack(expected.get(), wanted);
+      equal = std::memcmp(current, wanted, sizeof(Words)) == 0;
+    }
+    if (!equal) {
+      seq_.store(seq, std::memory_order_release);
+      return false;
+    }
+    write(desired);
+    unlock(seq, desired.isJust());
+    return true;
+  }
+
+  bool isLockFree() const { return false; }
+
+  static constexpr bool alwaysLockFree = false;
+
+ private:
+  /* low bits of the sequence number, which is incremented by `step` */
+  static const std::uint64_t writing = 1;
+  static const std::uint64_t present = 2;
+  static const std::uint64_t step = 4;
+
+  static const std::size_t size =
+      (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+  using Words = std::uint64_t[size];
+
+  static void pack(const T& t, Words& words) {
+    std::memset(words, 0, sizeof(Words));
+    std::memcpy(words, &t, sizeof(T));
+  }
+
+  void read(Words& words) const {
+    for (std::size_t i = 0; i < size; ++i) {
+      words[i] = data_[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  void write(const Maybe<T>& m) {
+    if (m.isNothing()) {
+      return;
+    }
+    Words words;
+    pack(m.get(), words);
+    for (std::size_t i = 0; i < size; ++i) {
+      data_[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+
+  /* @return sequence number before locking */
+  std::uint64_t lock() {
+    std::uint64_t seq = seq_.load(std::memory_order_relaxed);
+    while (true) {
+      if (seq & writing) {
+        std::this_thread::yield();
+        seq = seq_.load(std::memory_order_relaxed);
+      } else if (seq_.compare_exchange_weak(seq, seq | writing,
+                                            std::memory_order_acquire,
+                                            std::memory_order_relaxed)) {
+        /* readers seeing any of the following writes see `writing` */
+        std::atomic_thread_fence(std::memory_order_release);
+        return seq;
+      }
+    }
+  }
+
+  void unlock(std::uint64_t seq, bool isPresent) {
+    seq_.store((seq & ~(writing | present)) + step + (isPresent ? present : 0),
+               std::memory_order_release);
+  }
+
+  std::atomic<std::uint64_t> seq_{0};
+  std::atomic<std::uint64_t> data_[size];
+};
+}  // namespace detail
+
+/**
+ * Maybe<T> that can be published, read and taken concurrently without a
+ * mutex.
+ *
+ * Intended to hand results from producer threads to many readers, e.g.
+ * ~~~
+ * AtomicMaybe<Stats> latest;
+ * // producer
+ * latest.store(computeStats());
+ * // readers
+ * latest.load().map(display);
+ * ~~~
+ *
+ * `T` must be trivially copyable. Types smaller than 8 bytes are packed with
+ * a presence flag into one atomic word, making all operations lock free.
+ * Types of 8 bytes, such as `int64_t`, `double` or pointers, are stored next
+ * to a tag word and updated by a double word compare and swap where the
+ * target has one (`MARJORAM_HAS_DOUBLE_WORD_CAS`), also lock free. Larger
+ * types are protected by a sequence lock, where `load` never blocks writers
+ * (it retries instead) and writers exclude each other by spinning.
+ *
+ * Values are compared bytewise, like std::atomic does: padding bytes take
+ * part in the comparison of `compareAndSet`.
+ */
+template <typename T> class AtomicMaybe {
+ public:
+  using value_type = T;
+
+  static_assert(std::is_trivially_copyable<T>::value,
+                "AtomicMaybe<T>: T must be trivially copyable.");
+
+  /**
+   * Constructs a slot holding Nothing.
+   */
+  AtomicMaybe() {}
+
+  /**
+   * Constructs a slot holding `m`.
+   */
+  explicit AtomicMaybe(const Maybe<T>& m) { slot_.store(m); }
+
+  AtomicMaybe(const AtomicMaybe&) = delete;
+  AtomicMaybe& operator=(const AtomicMaybe&) = delete;
+
+  /**
+   * @return Snapshot of the current value.
+   */
+  Maybe<T> load() const { return slot_.load(); }
+
+  /**
+   * Replaces the current value by `m`.
+   */
+  void store(const Maybe<T>& m) { slot_.store(m); }
+
+  /**
+   * Replaces the current value by `m`.
+   * @return Previous value.
+   */
+  Maybe<T> exchange(const Maybe<T>& m) { return slot_.exchange(m); }
+
+  /**
+   * Empties the slot. Of several threads taking the same value, only one
+   * receives it.
+   * @return Previous value.
+   */
+  Maybe<T> take() { return slot_.exchange(Nothing); }
+
+  /**
+   * Replaces the current value by `desired` if it equals `expected`.
+   * @return true iff the value was replaced.
+   */
+  bool compareAndSet(const Maybe<T>& expected, const Maybe<T>& desired) {
+    return slot_.compareAndSet(expected, desired);
+  }
+
+  /**
+   * @return true iff no operation ever waits for another thread.
+   */
+  bool isLockFree() const { return slot_.isLockFree(); }
+
+ private:
+#ifdef MARJORAM_HAS_DOUBLE_WORD_CAS
+  using WordSlot = detail::DoubleWordSlot<T>;
+#else
+  using WordSlot = detail::SeqlockSlot<T>;
+#endif
+  using Slot = std::conditional_t<
+      (sizeof(T) < sizeof(std::uint64_t)), detail::PackedSlot<T>,
+      std::conditional_t<sizeof(T) == sizeof(std::uint64_t), WordSlot,
+                         detail::SeqlockSlot<T>>>;
+
+ public:
+  /**
+   * true iff all operations are lock free for any `AtomicMaybe<T>`.
+   */
+  static constexpr bool isAlwaysLockFree = Slot::alwaysLockFree;
+
+ private:
+
+  Slot slot_;
+};
+// @}
+}  // namespace ma
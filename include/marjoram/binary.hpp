@@ -0,0 +1,379 @@
+#pragma once
+
+#include "either.hpp"
+#include "maybe.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+namespace ma {
+/**
+ * @defgroup Binary Binary
+ * @addtogroup Binary
+ * @{
+ * Binary encoding of Maybe and Either, read in place.
+ *
+ * A `Maybe<T>` is encoded as a tag byte, padding to the alignment of `T` and
+ * the encoding of `T`; an `Either<A, B>` likewise, with room for the larger
+ * of `A` and `B`. Payloads nest, and other types must be trivially copyable,
+ * they are encoded as their bytes. Every encoding has a fixed size,
+ * `Encoding<T>::size`, a multiple of `Encoding<T>::alignment`. Absent
+ * payloads are zero filled, such that equal values have equal encodings.
+ *
+ * Views access an encoding in place: `view<T>(data)` reads a tag and returns
+ * a view of the payload, without decoding the whole value. Buffers should be
+ * aligned to `Encoding<T>::alignment` for aligned loads.
+ *
+ * Ranges are encoded with their tags packed into a bit array, followed by the
+ * payloads at a fixed stride, see encodeRange.
+ *
+ * The encoding uses the byte order and layout of the machine, it is meant
+ * for buffers exchanged between processes on the same architecture.
+ *
+ * Example
+ * -------
+ * ~~~
+ * std::vector<Maybe<double>> prices = ...;
+ * std::vector<unsigned char> buffer(encodedRangeSize<Maybe<double>>(n));
+ * encodeRange(prices.begin(), prices.end(), buffer.data());
+ *
+ * RangeView<Maybe<double>> view(buffer.data(), n);
+ * double first = view[0].isJust() ? view[0].get() : 0.0;
+ * ~~~
+ */
+
+template <typename T> struct Encoding;
+template <typename T> class MaybeView;
+template <typename A, typename B> class EitherView;
+
+namespace detail {
+constexpr std::size_t roundUp(std::size_t n, std::size_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+constexpr std::size_t maxOf(std::size_t a, std::size_t b) {
+  return a < b ? b : a;
+}
+}  // namespace detail
+
+/**
+ * Encoding of a trivially copyable type, its bytes.
+ */
+template <typename T> struct Encoding {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Encoding<T>: T must be trivially copyable, Maybe or Either.");
+
+  static constexpr std::size_t size = sizeof(T);
+  static constexpr std::size_t alignment = alignof(T);
+
+  using view_type = T;
+
+  static void write(const T& t, unsigned char* out) {
+    std::memcpy(out, &t, sizeof(T));
+  }
+
+  static view_type view(const unsigned char* in) {
+    std::aligned_storage_t<sizeof(T), alignof(T)> storage;
+    std::memcpy(&storage, in, sizeof(T));
+    return *reinterpret_cast<const T*>(&storage);
+  }
+
+  static T decode(const unsigned char* in) { return view(in); }
+};
+
+/**
+ * Encoding of `Maybe<T>`: tag, 1 if present, and payload.
+ */
+template <typename T> struct Encoding<Maybe<T>> {
+  using payload = Encoding<T>;
+
+  static constexpr std::size_t alignment = payload::alignment;
+  /* offset of the payload */
+  static constexpr std::size_t offset = alignment;
+  static constexpr std::size_t payloadSize = payload::size;
+  static constexpr std::size_t size = offset + payloadSize;
+
+  using view_type = MaybeView<T>;
+
+  static bool tag(const Maybe<T>& m) { return m.isJust(); }
+
+  static void writePayload(const Maybe<T>& m, unsigned char* out) {
+    if (m.isJust()) {
+      payload::write(m.get(), out);
+    } else {
+      std::memset(out, 0, payloadSize);
+    }
+  }
+
+  static void write(const Maybe<T>& m, unsigned char* out) {
+    std::memset(out, 0, offset);
+    out[0] = tag(m);
+    writePayload(m, out + offset);
+  }
+
+  static view_type view(bool tag, const unsigned char* payload) {
+    return view_type(tag, payload);
+  }
+
+  static view_type view(const unsigned char* in) {
+    return view(in[0] != 0, in + offset);
+  }
+
+  static Maybe<T> decode(bool tag, const unsigned char* payload) {
+    return view(tag, payload).toMaybe();
+  }
+
+  static Maybe<T> decode(const unsigned char* in) {
+    return view(in).toMaybe();
+  }
+};
+
+/**
+ * Encoding of `Either<A, B>`: tag, 1 if right, and payload.
+ */
+template <typename A, typename B> struct Encoding<Either<A, B>> {
+  static_assert(!std::is_reference<B>::value,
+                "Encoding<Either<A, B>>: B must be a value type.");
+  using left = Encoding<A>;
+  using right = Encoding<B>;
+
+  static constexpr std::size_t alignment =
+      detail::maxOf(left::alignment, right::alignment);
+  /* offset of the payload */
+  static constexpr std::size_t offset = alignment;
+  static constexpr std::size_t payloadSize = detail::roundUp(
+      detail::maxOf(left::size, right::size), alignment);
+  static constexpr std::size_t size = offset + payloadSize;
+
+  using view_type = EitherView<A, B>;
+
+  static bool tag(const Either<A, B>& e) { return e.isRight(); }
+
+  static void writePayload(const Either<A, B>& e, unsigned char* out) {
+    std::memset(out, 0, payloadSize);
+    if (e.isRight()) {
+      right::write(e.asRight(), out);
+    } else {
+      left::write(e.asLeft(), out);
+    }
+  }
+
+  static void write(const Either<A, B>& e, unsigned char* out) {
+    std::memset(out, 0, offset);
+    out[0] = tag(e);
+    writePayload(e, out + offset);
+  }
+
+  static view_type view(bool tag, const unsigned char* payload) {
+    return view_type(tag, payload);
+  }
+
+  static view_type view(const unsigned char* in) {
+    return view(in[0] != 0, in + offset);
+  }
+
+  static Either<A, B> decode(bool tag, const unsigned char* payload) {
+    return view(tag, payload).toEither();
+  }
+
+  static Either<A, B> decode(const unsigned char* in) {
+    return view(in).toEither();
+  }
+};
+
+/**
+ * Encoded `Maybe<T>`, read in place.
+ */
+template <typename T> class MaybeView {
+ public:
+  MaybeView(bool just, const unsigned char* payload)
+      : just_(just), payload_(payload) {}
+
+  bool isJust() const { return just_; }
+  bool isNothing() const { return !just_; }
+
+  /**
+   * Returns the view of the payload, `T` itself for trivially copyable `T`.
+   *
+   * Undefined behavior if Nothing is encoded.
+   */
+  typename Encoding<T>::view_type get() const {
+    assert(just_);
+    return Encoding<T>::view(payload_);
+  }
+
+  /**
+   * @return The encoding of the payload.
+   */
+  const unsigned char* data() const { return payload_; }
+
+  /**
+   * @return The decoded Maybe.
+   */
+  Maybe<T> toMaybe() const {
+    if (just_) {
+      return Maybe<T>(Encoding<T>::decode(payload_));
+    }
+    return Nothing;
+  }
+
+ private:
+  bool just_;
+  const unsigned char* payload_;
+};
+
+/**
+ * Encoded `Either<A, B>`, read in place.
+ */
+template <typename A, typename B> class EitherView {
+ public:
+  EitherView(bool right, const unsigned char* payload)
+      : right_(right), payload_(payload) {}
+
+  bool isLeft() const { return !right_; }
+  bool isRight() const { return right_; }
+
+  /**
+   * Returns the view of the left payload.
+   *
+   * Undefined behavior if a right value is encoded.
+   */
+  typename Encoding<A>::view_type asLeft() const {
+    assert(!right_);
+    return Encoding<A>::view(payload_);
+  }
+
+  /**
+   * Returns the view of the right payload.
+   *
+   * Undefined behavior if a left value is encoded.
+   */
+  typename Encoding<B>::view_type asRight() const {
+    assert(right_);
+    return Encoding<B>::view(payload_);
+  }
+
+  /**
+   * @return The encoding of the payload.
+   */
+  const unsigned char* data() const { return payload_; }
+
+  /**
+   * @return The decoded Either.
+   */
+  Either<A, B> toEither() const {
+    if (right_) {
+      return Either<A, B>(Right, Encoding<B>::decode(payload_));
+    }
+    return Either<A, B>(Left, Encoding<A>::decode(payload_));
+  }
+
+ private:
+  bool right_;
+  const unsigned char* payload_;
+};
+
+/**
+ * Encodes `t` into the `Encoding<T>::size` bytes at `out`.
+ */
+template <typename T> void encode(const T& t, unsigned char* out) {
+  Encoding<T>::write(t, out);
+}
+
+/**
+ * @return View of the encoded `T` at `in`.
+ */
+template <typename T>
+typename Encoding<T>::view_type view(const unsigned char* in) {
+  return Encoding<T>::view(in);
+}
+
+/**
+ * @return `T` decoded from `in`.
+ */
+template <typename T> T decode(const unsigned char* in) {
+  return Encoding<T>::decode(in);
+}
+
+/**
+ * @return Size of the encoding of `n` values of type `T`, a Maybe or Either,
+ * by encodeRange.
+ */
+template <typename T> constexpr std::size_t encodedRangeSize(std::size_t n) {
+  return detail::roundUp((n + 7) / 8, Encoding<T>::alignment) +
+         n * Encoding<T>::payloadSize;
+}
+
+/**
+ * Encodes a range of Maybe or Either values.
+ *
+ * The tags are packed into bits, least significant first, padded to the
+ * alignment of the payloads, which follow at a fixed stride.
+ *
+ * @param out Buffer of `encodedRangeSize<T>(n)` bytes.
+ * @return Number of bytes written.
+ */
+template <typename It>
+std::size_t encodeRange(It first, It last, unsigned char* out) {
+  using T = typename std::iterator_traits<It>::value_type;
+  using E = Encoding<T>;
+  const std::size_t n = std::distance(first, last);
+  const std::size_t size = encodedRangeSize<T>(n);
+  const std::size_t tags = size - n * E::payloadSize;
+  std::memset(out, 0, tags);
+  unsigned char* payload = out + tags;
+  for (std::size_t i = 0; first != last; ++first, ++i) {
+    out[i / 8] |= static_cast<unsigned char>(E::tag(*first) << (i % 8));
+    E::writePayload(*first, payload);
+    payload += E::payloadSize;
+  }
+  return size;
+}
+
+/**
+ * Range encoded by encodeRange, read in place.
+ */
+template <typename T> class RangeView {
+  using E = Encoding<T>;
+
+ public:
+  RangeView(const unsigned char* data, std::size_t n)
+      : tags_(data),
+        payloads_(data + detail::roundUp((n + 7) / 8, E::alignment)),
+        size_(n) {}
+
+  std::size_t size() const { return size_; }
+
+  /**
+   * @return View of element `i`.
+   */
+  typename E::view_type operator[](std::size_t i) const {
+    assert(i < size_);
+    return E::view(tag(i), payload(i));
+  }
+
+  /**
+   * Decodes all elements into `out`.
+   */
+  template <typename OutputIt> OutputIt decode(OutputIt out) const {
+    for (std::size_t i = 0; i < size_; ++i) {
+      *out++ = E::decode(tag(i), payload(i));
+    }
+    return out;
+  }
+
+ private:
+  bool tag(std::size_t i) const { return ((tags_[i / 8] >> (i % 8)) & 1) != 0; }
+
+  const unsigned char* payload(std::size_t i) const {
+    return payloads_ + i * E::payloadSize;
+  }
+
+  const unsigned char* tags_;
+  const unsigned char* payloads_;
+  std::size_t size_;
+};
+// @}
+}  // namespace ma
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "either.hpp"
+#include "maybe.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace ma {
+/**
+ * @defgroup Channel Channel
+ * @addtogroup Channel
+ * @{
+ * Bounded multi-producer multi-consumer queue for passing values between
+ * threads, e.g. `Either<Err, Record>` between the stages of a pipeline.
+ *
+ * Example
+ * -------
+ * ~~~
+ * Channel<Either<Err, Record>> records(1024);
+ * // producer
+ * for (auto& r : read(file)) {
+ *   records.push(std::move(r));
+ * }
+ * records.close();
+ * // consumer
+ * while (true) {
+ *   auto r = records.pop();
+ *   if (r.isLeft()) {
+ *     break;  // closed and drained
+ *   }
+ *   process(std::move(r.asRight()));
+ * }
+ * ~~~
+ */
+
+/**
+ * Left value of `Channel::pop` once a channel is closed and drained.
+ */
+struct Closed {};
+
+/**
+ * Bounded lock-free MPMC ring buffer with close semantics.
+ *
+ * Non-blocking operations (`tryPush`, `tryPop` and their batched variants)
+ * never take a lock. Blocking operations spin briefly, then sleep until the
+ * channel is ready; waking sleepers costs producers and consumers a lock only
+ * while someone actually sleeps.
+ *
+ * After `close`, pushes fail and pops drain the remaining values, then return
+ * Closed.
+ *
+ * Batched operations claim all slots they transfer with a single atomic
+ * operation.
+ */
+template <typename T> class Channel {
+ public:
+  using value_type = T;
+
+  /**
+   * @param capacity Maximum number of values held, rounded up to a power of
+   * two.
+   */
+  explicit Channel(std::size_t capacity) : mask_(roundUp(capacity) - 1) {
+    cells_.reset(new Cell[mask_ + 1]);
+    for (std::size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  Channel(const Channel&) = delete;
+  Channel& operator=(const Channel&) = delete;
+
+  ~Channel() {
+    const std::size_t end = enqueue_.load() & ~closedBit;
+    for (std::size_t pos = dequeue_.load(); pos != end; ++pos) {
+      cells_[pos & mask_].value().~T();
+    }
+  }
+
+  /**
+   * @return Maximum number of values held.
+   */
+  std::size_t capacity() const { return mask_ + 1; }
+
+  /**
+   * @return true iff `close` has been called.
+   */
+  bool isClosed() const {
+    return enqueue_.load(std::memory_order_acquire) & closedBit;
+  }
+
+  /**
+   * Prevents further pushes and wakes up all waiting threads.
+   */
+  void close() {
+    enqueue_.fetch_or(closedBit, std::memory_order_acq_rel);
+    std::lock_guard<std::mutex> lock(mutex_);
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+  }
+
+  /**
+   * Pushes `value` unless the channel is full or closed.
+   * @return true iff `value` was pushed. Otherwise `value` is left untouched.
+   */
+  bool tryPush(const T& value) { return tryPushImpl(value); }
+
+  /**
+   * Pushes `value` unless the channel is full or closed.
+   * @return true iff `value` was moved into the channel. Otherwise `value` is
+   * left untouched.
+   */
+  bool tryPush(T&& value) { return tryPushImpl(std::move(value)); }
+
+  /**
+   * Pushes `value`, waiting while the channel is full.
+   * @return false iff the channel is closed, in which case `value` is
+   * dropped.
+   */
+  bool push(T value) {
+    while (!tryPush(std::move(value))) {
+      if (isClosed()) {
+        return false;
+      }
+      await(pushSleepers_, notFull_, [this]() { return canPush(); });
+    }
+    return true;
+  }
+
+  /**
+   * Moves as many values from `[first, last)` into the channel as fit.
+   * @return Iterator past the last value pushed.
+   */
+  template <typename It> It tryPushBatch(It first, It last) {
+    std::size_t pos;
+    const std::size_t n =
+        claim(enqueue_, 0, std::size_t(std::distance(first, last)), pos);
+    for (std::size_t i = 0; i < n; ++i, ++first) {
+      put(pos + i, std::move(*first));
+    }
+    if (n) {
+      notify(popSleepers_, notEmpty_);
+    }
+    return first;
+  }
+
+  /**
+   * Moves all values from `[first, last)` into the channel, waiting while it
+   * is full.
+   * @return false iff the channel was closed before all values were pushed.
+   */
+  template <typename It> bool pushBatch(It first, It last) {
+    while ((first = tryPushBatch(first, last)) != last) {
+      if (isClosed()) {
+        return false;
+      }
+      await(pushSleepers_, notFull_, [this]() { return canPush(); });
+    }
+    return true;
+  }
+
+  /**
+   * @return Oldest value, or Nothing if the channel is empty.
+   */
+  Maybe<T> tryPop() {
+    std::size_t pos;
+    if (!claim(dequeue_, 1, 1, pos)) {
+      return Nothing;
+    }
+    Maybe<T> result(take(pos));
+    notify(pushSleepers_, notFull_);
+    return result;
+  }
+
+  /**
+   * @return Oldest value, waiting while the channel is empty. Closed if the
+   * channel is closed and all values have been popped.
+   */
+  Either<Closed, T> pop() {
+    while (true) {
+      std::size_t pos;
+      if (claim(dequeue_, 1, 1, pos)) {
+        Either<Closed, T> result(Right, take(pos));
+        notify(pushSleepers_, notFull_);
+        return result;
+      }
+      if (isDrained()) {
+        return Either<Closed, T>(Left);
+      }
+      await(popSleepers_, notEmpty_,
+            [this]() { return canPop() || isClosed(); });
+    }
+  }
+
+  /**
+   * Pops up to `max` values into `out`.
+   * @return Number of values popped.
+   */
+  template <typename OutputIt>
+  std::size_t tryPopBatch(OutputIt out, std::size_t max) {
+    std::size_t pos;
+    const std::size_t n = claim(dequeue_, 1, max, pos);
+    for (std::size_t i = 0; i < n; ++i, ++out) {
+      *out = take(pos + i);
+    }
+    if (n) {
+      notify(pushSleepers_, notFull_);
+    }
+    return n;
+  }
+
+  /**
+   * Pops up to `max` values into `out`, waiting while the channel is empty.
+   * @return Number of values popped, at least one unless `max` is zero.
+   * Closed if the channel is closed and all values have been popped.
+   */
+  template <typename OutputIt>
+  Either<Closed, std::size_t> popBatch(OutputIt out, std::size_t max) {
+    while (true) {
+      const std::size_t n = tryPopBatch(out, max);
+      if (n || !max) {
+        return Either<Closed, std::size_t>(Right, n);
+      }
+      if (isDrained()) {
+        return Either<Closed, std::size_t>(Left);
+      }
+      await(popSleepers_, notEmpty_,
+            [this]() { return canPop() || isClosed(); });
+    }
+  }
+
+ private:
+  /* set in `enqueue_` once closed */
+  static const std::size_t closedBit =
+      ~(std::numeric_limits<std::size_t>::max() >> 1);
+  static const int spins = 64;
+  static const std::size_t cacheLine = 64;
+
+  /*
+   * A cell at position `pos` is free iff its sequence is `pos`, and holds a
+   * value iff its sequence is `pos + 1`.
+   */
+  struct Cell {
+    T& value() { return *reinterpret_cast<T*>(&storage); }
+
+    std::atomic<std::size_t> sequence;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+  };
+
+  static std::size_t roundUp(std::size_t capacity) {
+    std::size_t n = 2;
+    while (n < capacity) {
+      n *= 2;
+    }
+    return n;
+  }
+
+  template <typename U> bool tryPushImpl(U&& value) {
+    std::size_t pos;
+    if (!claim(enqueue_, 0, 1, pos)) {
+      return false;
+    }
+    put(pos, std::forward<U>(value));
+    notify(popSleepers_, notEmpty_);
+    return true;
+  }
+
+  /*
+   * Claims up to `max` consecutive cells whose sequence is `ahead` past their
+   * position.
+   * @return Number of cells claimed, starting at `pos`.
+   */
+  std::size_t claim(std::atomic<std::size_t>& position, std::size_t ahead,
+                    std::size_t max, std::size_t& pos) {
+    pos = position.load(std::memory_order_relaxed);
+    while (max) {
+      if (pos & closedBit) {
+        return 0;
+      }
+      std::size_t n = 0;
+      while (n < max && sequence(pos + n) == pos + n + ahead) {
+        ++n;
+      }
+      if (n == 0) {
+        /* lagging behind means full (or empty), otherwise `pos` is stale */
+        if (std::ptrdiff_t(sequence(pos) - (pos + ahead)) < 0) {
+          return 0;
+        }
+        pos = position.load(std::memory_order_relaxed);
+      } else if (position.compare_exchange_weak(pos, pos + n,
+                                                std::memory_order_relaxed)) {
+        return n;
+      }
+    }
+    return 0;
+  }
+
+  std::size_t sequence(std::size_t pos) const {
+    return cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+  }
+
+  template <typename U> void put(std::size_t pos, U&& value) {
+    Cell& cell = cells_[pos & mask_];
+    new (&cell.storage) T(std::forward<U>(value));
+    cell.sequence.store(pos + 1, std::memory_order_release);
+  }
+
+  T take(std::size_t pos) {
+    Cell& cell = cells_[pos & mask_];
+    T value(std::move(cell.value()));
+    cell.value().~T();
+    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return value;
+  }
+
+  bool canPush() const {
+    const std::size_t pos = enqueue_.load(std::memory_order_relaxed);
+    return (pos & closedBit) || sequence(pos) == pos;
+  }
+
+  bool canPop() const {
+    const std::size_t pos = dequeue_.load(std::memory_order_relaxed);
+    return sequence(pos) == pos + 1;
+  }
+
+  /* closed, and every claimed cell has been popped */
+  bool isDrained() const {
+    const std::size_t end = enqueue_.load(std::memory_order_acquire);
+    return (end & closedBit) &&
+           dequeue_.load(std::memory_order_acquire) == (end & ~closedBit);
+  }
+
+  template <typename Ready>
+  void await(std::atomic<int>& sleepers, std::condition_variable& cv,
+             Ready ready) {
+    for (int i = 0; i < spins; ++i) {
+      if (ready()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    /* pairs with the fence in `notify`: either side sees the other */
+    sleepers.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv.wait(lock, ready);
+    }
+    sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void notify(std::atomic<int>& sleepers, std::condition_variable& cv) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleepers.load(std::memory_order_relaxed)) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv.notify_all();
+    }
+  }
+
+  const std::size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+  /* producers and consumers contend on different cache lines */
+  char pad0_[cacheLine];
+  std::atomic<std::size_t> enqueue_{0};
+  char pad1_[cacheLine];
+  std::atomic<std::size_t> dequeue_{0};
+  char pad2_[cacheLine];
+  std::atomic<int> pushSleepers_{0};
+  std::atomic<int> popSleepers_{0};
+  std::mutex mutex_;
+  std::condition_variable notEmpty_;
+  std::condition_variable notFull_;
+};
+// @}
+}  // namespace ma
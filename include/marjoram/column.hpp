@@ -0,0 +1,638 @@
+#pragma once
+
+#include "either.hpp"
+#include "maybe.hpp"
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+namespace ma {
+/**
+ * @addtogroup Binary
+ * @{
+ * Columns of Maybe or Either values, memory mapped from a file.
+ *
+ * A column file holds a header followed by four sections, each aligned to
+ * 64 bytes:
+ * - the validity bitmap, bit `i` set if row `i` is Just or right;
+ * - a rank directory, the number of set bits before every 512 rows;
+ * - the dense value section, the Just or right values in row order;
+ * - the left section, the left values in row order, empty for Maybe.
+ *
+ * Opening a column maps the file and checks the header, without reading the
+ * rows: row `i` is found in its section by counting the set bits before it,
+ * in constant time with the rank directory. Values must be trivially
+ * copyable, they are stored with the byte order and layout of the machine.
+ *
+ * Example
+ * -------
+ * ~~~
+ * writeColumn("prices.col", prices.begin(), prices.end());
+ *
+ * Either<std::string, MaybeColumn<double>> column =
+ *     openMaybeColumn<double>("prices.col");
+ * std::vector<double> filled = column.asRight().getOrElse(0.0);
+ * ~~~
+ */
+
+namespace detail {
+constexpr std::uint32_t columnVersion = 1;
+constexpr std::size_t columnAlignment = 64;
+/* rows counted by an entry of the rank directory */
+constexpr std::size_t rankBlock = 512;
+
+enum ColumnKind : std::uint32_t { maybeColumn, eitherColumn };
+
+struct ColumnHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t kind;
+  std::uint32_t rightSize;
+  std::uint32_t leftSize;
+  std::uint64_t rows;
+  /* offsets of the sections */
+  std::uint64_t bitmap;
+  std::uint64_t ranks;
+  std::uint64_t rights;
+  std::uint64_t lefts;
+};
+static_assert(sizeof(ColumnHeader) == columnAlignment,
+              "ColumnHeader must fill an aligned block.");
+
+constexpr char columnMagic[8] = {'M', 'A', 'C', 'O', 'L', 'U', 'M', 'N'};
+
+inline unsigned popcount(std::uint64_t word) {
+#if defined(__GNUC__)
+  return static_cast<unsigned>(__builtin_popcountll(word));
+#else
+  unsigned n = 0;
+  for (; word; word &= word - 1) {
+    ++n;
+  }
+  return n;
+#endif
+}
+
+inline std::size_t alignColumn(std::size_t n) {
+  return (n + columnAlignment - 1) / columnAlignment * columnAlignment;
+}
+
+/**
+ * Read-only mapping of a whole file.
+ */
+class MappedFile {
+ public:
+  /**
+   * @return The mapping of the file at `path`, or an error message.
+   */
+  static Either<std::string, std::shared_ptr<const MappedFile>> open(
+      const std::string& path) {
+    using Result = Either<std::string, std::shared_ptr<const MappedFile>>;
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return Result(Left, path + ": " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      const int error = errno;
+      ::close(fd);
+      return Result(Left, path + ": " + std::strerror(error));
+    }
+    if (st.st_size == 0) {
+      ::close(fd);
+      return Result(Left, path + ": empty file");
+    }
+    const std::size_t size = static_cast<std::size_t>(st.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    const int error = errno;
+    ::close(fd);
+    if (data == MAP_FAILED) {
+      return Result(Left, path + ": " + std::strerror(error));
+    }
+    return Result(Right, std::shared_ptr<const MappedFile>(
+                             new MappedFile(data, size)));
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  ~MappedFile() { ::munmap(data_, size_); }
+
+  const unsigned char* data() const {
+    return static_cast<const unsigned char*>(data_);
+  }
+
+  std::size_t size() const { return size_; }
+
+ private:
+  MappedFile(void* data, std::size_t size) : data_(data), size_(size) {}
+
+  void* data_;
+  std::size_t size_;
+};
+
+/**
+ * Validity bitmap with its rank directory.
+ */
+class ColumnBitmap {
+ public:
+  ColumnBitmap(const std::uint64_t* words, const std::uint64_t* ranks)
+      : words_(words), ranks_(ranks) {}
+
+  bool test(std::size_t i) const { return (words_[i / 64] >> (i % 64)) & 1; }
+
+  /* number of set bits before row `i` */
+  std::size_t rank(std::size_t i) const {
+    std::size_t n = ranks_[i / rankBlock];
+    for (std::size_t w = i / rankBlock * (rankBlock / 64); w < i / 64; ++w) {
+      n += popcount(words_[w]);
+    }
+    if (i % 64) {
+      n += popcount(words_[i / 64] & ((std::uint64_t(1) << (i % 64)) - 1));
+    }
+    return n;
+  }
+
+  /**
+   * Calls `f(i, set, rank)` for rows `[0, rows)`, in order.
+   */
+  template <typename F> void forEach(std::size_t rows, F f) const {
+    std::size_t rank = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+      const bool set = test(i);
+      f(i, set, rank);
+      rank += set;
+    }
+  }
+
+ private:
+  const std::uint64_t* words_;
+  const std::uint64_t* ranks_;
+};
+
+/**
+ * Sections of a mapped column file.
+ */
+struct ColumnSections {
+  std::shared_ptr<const MappedFile> file;
+  std::size_t rows;
+  ColumnBitmap bitmap;
+  const unsigned char* rights;
+  const unsigned char* lefts;
+};
+
+/* checks the header and the extent of the sections */
+inline Either<std::string, ColumnSections> openColumn(
+    const std::string& path, ColumnKind kind, std::size_t rightSize,
+    std::size_t leftSize) {
+  using Result = Either<std::string, ColumnSections>;
+  return MappedFile::open(path).flatMap(
+      [&](const std::shared_ptr<const MappedFile>& file) -> Result {
+        auto fail = [&path](const char* message) {
+          return Result(Left, path + ": " + message);
+        };
+        ColumnHeader header;
+        if (file->size() < sizeof(header)) {
+          return fail("not a column file");
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, columnMagic, sizeof(columnMagic)) != 0) {
+          return fail("not a column file");
+        }
+        if (header.version != columnVersion) {
+          return fail("unsupported column version");
+        }
+        if (header.kind != kind || header.rightSize != rightSize ||
+            header.leftSize != leftSize) {
+          return fail("column type mismatch");
+        }
+        const std::uint64_t rows = header.rows;
+        /* each row takes a bit at least, also keeps the counts below from
+         * wrapping around */
+        if (rows / 8 > file->size()) {
+          return fail("truncated column file");
+        }
+        const std::uint64_t words = (rows + 63) / 64;
+        const std::uint64_t blocks = (rows + rankBlock - 1) / rankBlock;
+        const std::uint64_t offsets[] = {header.bitmap, header.ranks,
+                                         header.rights, header.lefts};
+        for (std::uint64_t offset : offsets) {
+          if (offset % columnAlignment || offset > file->size()) {
+            return fail("corrupt section offsets");
+          }
+        }
+        if (file->size() - header.bitmap < words * 8 ||
+            file->size() - header.ranks < (blocks + 1) * 8) {
+          return fail("truncated column file");
+        }
+        const auto* data = file->data();
+        const auto* ranks =
+            reinterpret_cast<const std::uint64_t*>(data + header.ranks);
+        ColumnBitmap bitmap(
+            reinterpret_cast<const std::uint64_t*>(data + header.bitmap),
+            ranks);
+        /* the directory ends with the total number of set bits */
+        const std::uint64_t set = ranks[blocks];
+        if (set > rows ||
+            (file->size() - header.rights) / (rightSize ? rightSize : 1) <
+                set ||
+            (file->size() - header.lefts) / (leftSize ? leftSize : 1) <
+                (leftSize ? rows - set : 0)) {
+          return fail("truncated column file");
+        }
+        /* rank() trusts the directory, so it has to start at 0 and each
+         * block may add at most its own bits; monotonic entries ending in
+         * set are also bounded by it */
+        if (ranks[0] != 0) {
+          return fail("corrupt rank directory");
+        }
+        for (std::uint64_t b = 0; b < blocks; ++b) {
+          if (ranks[b + 1] < ranks[b] || ranks[b + 1] - ranks[b] > rankBlock) {
+            return fail("corrupt rank directory");
+          }
+        }
+        return Result(Right,
+                      ColumnSections{file, static_cast<std::size_t>(rows),
+                                     bitmap, data + header.rights,
+                                     data + header.lefts});
+      });
+}
+
+/* placeholder for the left values of a Maybe column */
+struct NoLeft {};
+
+/**
+ * Collects rows in memory and writes them as a column file.
+ */
+template <typename R, typename L> class ColumnBuilder {
+ public:
+  void right(const R& r) {
+    set(true);
+    rights_.push_back(r);
+  }
+
+  void left(const L& l) {
+    set(false);
+    lefts_.push_back(l);
+  }
+
+  void nothing() { set(false); }
+
+  Either<std::string, std::size_t> write(const std::string& path,
+                                         ColumnKind kind) const {
+    const std::size_t leftSize = std::is_same<L, NoLeft>::value ? 0 : sizeof(L);
+    const std::size_t blocks = (rows_ + rankBlock - 1) / rankBlock;
+    ColumnHeader header;
+    std::memcpy(header.magic, columnMagic, sizeof(columnMagic));
+    header.version = columnVersion;
+    header.kind = kind;
+    header.rightSize = sizeof(R);
+    header.leftSize = static_cast<std::uint32_t>(leftSize);
+    header.rows = rows_;
+    header.bitmap = sizeof(header);
+    header.ranks = header.bitmap + alignColumn(words_.size() * 8);
+    header.rights = header.ranks + alignColumn((blocks + 1) * 8);
+    header.lefts = header.rights + alignColumn(rights_.size() * sizeof(R));
+    const std::size_t size =
+        header.lefts + alignColumn(lefts_.size() * leftSize);
+
+    std::vector<std::uint64_t> ranks;
+    std::uint64_t set = 0;
+    for (std::size_t w = 0; w < words_.size(); ++w) {
+      if (w % (rankBlock / 64) == 0) {
+        ranks.push_back(set);
+      }
+      set += popcount(words_[w]);
+    }
+    ranks.push_back(set);
+
+    std::vector<unsigned char> bytes(size);
+    std::memcpy(bytes.data(), &header, sizeof(header));
+    copy(words_, bytes.data() + header.bitmap);
+    copy(ranks, bytes.data() + header.ranks);
+    copy(rights_, bytes.data() + header.rights);
+    if (leftSize) {
+      copy(lefts_, bytes.data() + header.lefts);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    out.close();
+    if (!out) {
+      return Either<std::string, std::size_t>(Left,
+                                              path + ": write failed");
+    }
+    return Either<std::string, std::size_t>(Right, size);
+  }
+
+ private:
+  void set(bool bit) {
+    if (rows_ % 64 == 0) {
+      words_.push_back(0);
+    }
+    words_.back() |= std::uint64_t(bit) << (rows_ % 64);
+    ++rows_;
+  }
+
+  template <typename T>
+  static void copy(const std::vector<T>& v, unsigned char* out) {
+    if (!v.empty()) {
+      std::memcpy(out, v.data(), v.size() * sizeof(T));
+    }
+  }
+
+  std::size_t rows_ = 0;
+  std::vector<std::uint64_t> words_;
+  std::vector<R> rights_;
+  std::vector<L> lefts_;
+};
+
+template <typename T>
+void addRow(ColumnBuilder<T, NoLeft>& b, const Maybe<T>& m) {
+  if (m.isJust()) {
+    b.right(m.get());
+  } else {
+    b.nothing();
+  }
+}
+
+template <typename A, typename B>
+void addRow(ColumnBuilder<B, A>& b, const Either<A, B>& e) {
+  if (e.isRight()) {
+    b.right(e.asRight());
+  } else {
+    b.left(e.asLeft());
+  }
+}
+
+template <typename T> struct ColumnOf;
+
+template <typename T> struct ColumnOf<Maybe<T>> {
+  using builder = ColumnBuilder<T, NoLeft>;
+  static constexpr ColumnKind kind = maybeColumn;
+};
+
+template <typename A, typename B> struct ColumnOf<Either<A, B>> {
+  using builder = ColumnBuilder<B, A>;
+  static constexpr ColumnKind kind = eitherColumn;
+};
+}  // namespace detail
+
+/**
+ * Column of `Maybe<T>`, read in place from a mapped file.
+ *
+ * Rows are accessed as `Maybe<const T&>`, referring into the mapping, which
+ * lives as long as any copy of the column.
+ */
+template <typename T> class MaybeColumn {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "MaybeColumn<T>: T must be trivially copyable.");
+  static_assert(alignof(T) <= detail::columnAlignment,
+                "MaybeColumn<T>: T is overaligned.");
+
+ public:
+  explicit MaybeColumn(detail::ColumnSections sections)
+      : sections_(std::move(sections)) {}
+
+  /**
+   * @return Number of rows.
+   */
+  std::size_t size() const { return sections_.rows; }
+
+  bool isJust(std::size_t i) const { return sections_.bitmap.test(i); }
+
+  /**
+   * @return Row `i`, in constant time.
+   */
+  Maybe<const T&> operator[](std::size_t i) const {
+    if (!isJust(i)) {
+      return Nothing;
+    }
+    return Maybe<const T&>(values()[sections_.bitmap.rank(i)]);
+  }
+
+  /**
+   * Calls `f` with every row, as `Maybe<const T&>`, in order.
+   */
+  template <typename F> void forEach(F f) const {
+    const T* vs = values();
+    sections_.bitmap.forEach(size(), [&](std::size_t, bool set,
+                                         std::size_t rank) {
+      f(set ? Maybe<const T&>(vs[rank]) : Maybe<const T&>());
+    });
+  }
+
+  /**
+   * @return The rows mapped with `f`, as in `Maybe::map`.
+   */
+  template <typename F>
+  auto map(F f) const -> std::vector<Maybe<std::result_of_t<F(const T&)>>> {
+    std::vector<Maybe<std::result_of_t<F(const T&)>>> out;
+    out.reserve(size());
+    forEach([&](const Maybe<const T&>& m) { out.push_back(m.map(f)); });
+    return out;
+  }
+
+  /**
+   * @return The rows, with Nothing where `pred` does not hold.
+   */
+  template <typename Pred> std::vector<Maybe<T>> filter(Pred pred) const {
+    std::vector<Maybe<T>> out;
+    out.reserve(size());
+    forEach([&](const Maybe<const T&>& m) {
+      out.push_back(m.exists(pred) ? Maybe<T>(m.get()) : Maybe<T>());
+    });
+    return out;
+  }
+
+  /**
+   * @return The values, `dflt` for Nothing.
+   */
+  std::vector<T> getOrElse(const T& dflt) const {
+    std::vector<T> out;
+    out.reserve(size());
+    forEach(
+        [&](const Maybe<const T&>& m) { out.push_back(m.getOrElse(dflt)); });
+    return out;
+  }
+
+  /**
+   * @return The dense value section, the Just values in row order.
+   */
+  const T* values() const {
+    return reinterpret_cast<const T*>(sections_.rights);
+  }
+
+ private:
+  detail::ColumnSections sections_;
+};
+
+/**
+ * Column of `Either<A, B>`, read in place from a mapped file.
+ *
+ * Rows are accessed as `Either<A, const B&>`: right values refer into the
+ * mapping, left values are copied.
+ */
+template <typename A, typename B> class EitherColumn {
+  static_assert(std::is_trivially_copyable<A>::value &&
+                    std::is_trivially_copyable<B>::value,
+                "EitherColumn<A, B>: A and B must be trivially copyable.");
+  static_assert(alignof(A) <= detail::columnAlignment &&
+                    alignof(B) <= detail::columnAlignment,
+                "EitherColumn<A, B>: A or B is overaligned.");
+
+ public:
+  explicit EitherColumn(detail::ColumnSections sections)
+      : sections_(std::move(sections)) {}
+
+  /**
+   * @return Number of rows.
+   */
+  std::size_t size() const { return sections_.rows; }
+
+  bool isRight(std::size_t i) const { return sections_.bitmap.test(i); }
+
+  /**
+   * @return Row `i`, in constant time.
+   */
+  Either<A, const B&> operator[](std::size_t i) const {
+    const std::size_t rank = sections_.bitmap.rank(i);
+    if (isRight(i)) {
+      return Either<A, const B&>(Right, rights()[rank]);
+    }
+    return Either<A, const B&>(Left, lefts()[i - rank]);
+  }
+
+  /**
+   * Calls `f` with every row, as `Either<A, const B&>`, in order.
+   */
+  template <typename F> void forEach(F f) const {
+    const A* ls = lefts();
+    const B* rs = rights();
+    sections_.bitmap.forEach(size(), [&](std::size_t i, bool set,
+                                         std::size_t rank) {
+      f(set ? Either<A, const B&>(Right, rs[rank])
+            : Either<A, const B&>(Left, ls[i - rank]));
+    });
+  }
+
+  /**
+   * @return The rows mapped with `f`, as in `Either::map`.
+   */
+  template <typename F>
+  auto map(F f) const
+      -> std::vector<Either<A, std::result_of_t<F(const B&)>>> {
+    std::vector<Either<A, std::result_of_t<F(const B&)>>> out;
+    out.reserve(size());
+    forEach([&](const Either<A, const B&>& e) { out.push_back(e.map(f)); });
+    return out;
+  }
+
+  /**
+   * @return The rows, with left value `a` where `pred` does not hold, as in
+   * `Either::filterOrElse`.
+   */
+  template <typename Pred>
+  std::vector<Either<A, B>> filterOrElse(Pred pred, const A& a) const {
+    std::vector<Either<A, B>> out;
+    out.reserve(size());
+    forEach([&](const Either<A, const B&>& e) {
+      if (e.isLeft()) {
+        out.emplace_back(Left, e.asLeft());
+      } else if (pred(e.asRight())) {
+        out.emplace_back(Right, e.asRight());
+      } else {
+        out.emplace_back(Left, a);
+      }
+    });
+    return out;
+  }
+
+  /**
+   * @return The right values, `dflt` for left values.
+   */
+  std::vector<B> getOrElse(const B& dflt) const {
+    std::vector<B> out;
+    out.reserve(size());
+    forEach([&](const Either<A, const B&>& e) {
+      out.push_back(e.isRight() ? e.asRight() : dflt);
+    });
+    return out;
+  }
+
+  /**
+   * @return The dense value section, the right values in row order.
+   */
+  const B* rights() const {
+    return reinterpret_cast<const B*>(sections_.rights);
+  }
+
+  /**
+   * @return The left section, the left values in row order.
+   */
+  const A* lefts() const {
+    return reinterpret_cast<const A*>(sections_.lefts);
+  }
+
+ private:
+  detail::ColumnSections sections_;
+};
+
+/**
+ * Writes a range of `Maybe<T>` or `Either<A, B>` as a column file.
+ *
+ * @return Size of the file, or an error message.
+ */
+template <typename It>
+Either<std::string, std::size_t> writeColumn(const std::string& path, It first,
+                                             It last) {
+  using Column =
+      detail::ColumnOf<typename std::iterator_traits<It>::value_type>;
+  typename Column::builder builder;
+  for (; first != last; ++first) {
+    detail::addRow(builder, *first);
+  }
+  return builder.write(path, Column::kind);
+}
+
+/**
+ * Maps the column file of `Maybe<T>` at `path`.
+ *
+ * @return The column, or an error message if the file cannot be mapped or is
+ * not a column of `Maybe<T>`.
+ */
+template <typename T>
+Either<std::string, MaybeColumn<T>> openMaybeColumn(const std::string& path) {
+  return detail::openColumn(path, detail::maybeColumn, sizeof(T), 0)
+      .map([](detail::ColumnSections sections) {
+        return MaybeColumn<T>(std::move(sections));
+      });
+}
+
+/**
+ * Maps the column file of `Either<A, B>` at `path`.
+ *
+ * @return The column, or an error message if the file cannot be mapped or is
+ * not a column of `Either<A, B>`.
+ */
+template <typename A, typename B>
+Either<std::string, EitherColumn<A, B>> openEitherColumn(
+    const std::string& path) {
+  return detail::openColumn(path, detail::eitherColumn, sizeof(B), sizeof(A))
+      .map([](detail::ColumnSections sections) {
+        return EitherColumn<A, B>(std::move(sections));
+      });
+}
+// @}
+}  // namespace ma
@@ -0,0 +1,457 @@
+#pragma once
+
+/*
+ * Maybe and Either coroutines need the result of get_return_object to be
+ * converted to the return type once the coroutine suspended or completed,
+ * which the standard leaves open (CWG2563). GCC and Clang, except 15 and 16,
+ * do so; MSVC converts before the coroutine body runs.
+ */
+#if defined(__clang__)
+#if defined(__apple_build_version__)
+#define MARJORAM_DEFERRED_RETURN_OBJECT (__clang_major__ >= 16)
+#else
+#define MARJORAM_DEFERRED_RETURN_OBJECT \
+  (__clang_major__ < 15 || __clang_major__ >= 17)
+#endif
+#elif defined(__GNUC__)
+#define MARJORAM_DEFERRED_RETURN_OBJECT 1
+#else
+#define MARJORAM_DEFERRED_RETURN_OBJECT 0
+#endif
+
+/*
+ * GCC releases the frame when an exception leaves the initial call of a
+ * coroutine, even if the coroutine already completed, so the frame of a
+ * Maybe or Either coroutine that failed is left to it.
+ */
+#if defined(__GNUC__) && !defined(__clang__)
+#define MARJORAM_CALLER_RELEASES_FAILED_FRAME 1
+#else
+#define MARJORAM_CALLER_RELEASES_FAILED_FRAME 0
+#endif
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>) && MARJORAM_DEFERRED_RETURN_OBJECT
+#define MARJORAM_HAS_COROUTINES 1
+#endif
+#endif
+
+#ifdef MARJORAM_HAS_COROUTINES
+#include "either.hpp"
+#include "lazy.hpp"
+#include "maybe.hpp"
+#include <cassert>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace ma {
+/**
+ * @defgroup Coroutine Coroutine
+ * @addtogroup Coroutine
+ * @{
+ * C++20 coroutine support for Maybe, Either and Lazy.
+ *
+ * Only available if the compiler supports coroutines (`-std=c++20`), in
+ * which case `MARJORAM_HAS_COROUTINES` is defined. Maybe and Either
+ * coroutines return an object that converts to the result once the coroutine
+ * completed, so the compiler must convert the return object after the body
+ * ran: support is restricted to GCC and Clang other than 15 and 16, which
+ * do; MSVC does not.
+ *
+ * A function returning `Maybe<T>` or `Either<E, T>` may be written as a
+ * coroutine: `co_await` on a Maybe (respectively an Either whose left type
+ * converts to `E`) yields the contained value, or returns Nothing (the left
+ * value) from the coroutine immediately. This replaces nested `flatMap` calls
+ * by sequential code:
+ *
+ * ~~~
+ * Maybe<int> parse(const std::string& s);
+ * Maybe<double> divide(int a, int b);
+ *
+ * Maybe<double> ratio(const std::string& a, const std::string& b) {
+ *   int x = co_await parse(a);
+ *   int y = co_await parse(b);
+ *   co_return co_await divide(x, y);
+ * }
+ * ~~~
+ *
+ * A coroutine returning `Lazy<A>` does not run until `get` is called on the
+ * returned value; `co_await` on a Lazy evaluates it.
+ *
+ * ~~~
+ * Lazy<Report> report(const Lazy<Index>& index) {
+ *   const Index& i = co_await index;
+ *   co_return buildReport(i);
+ * }
+ * ~~~
+ *
+ * Coroutine frames are allocated from a per thread pool of recycled blocks.
+ * Exceptions escaping a Maybe or Either coroutine are rethrown to its caller
+ * when the return object converts to the result.
+ */
+
+namespace detail {
+/**
+ * Per thread free lists of coroutine frames, bucketed by size.
+ */
+class FramePool {
+ public:
+  static void* allocate(std::size_t size) {
+    const std::size_t c = sizeClass(size);
+    if (c >= classes) {
+      return ::operator new(size);
+    }
+    if (status() != dead) {
+      Lists& l = lists();
+      if (Block* b = l.heads[c]) {
+        l.heads[c] = b->next;
+        l.counts[c]--;
+        hitCount()++;
+        return b;
+      }
+    }
+    /* round up, so that blocks of a class are interchangeable */
+    return ::operator new((c + 1) * granularity);
+  }
+
+  static void deallocate(void* p, std::size_t size) {
+    const std::size_t c = sizeClass(size);
+    if (c < classes && status() != dead) {
+      Lists& l = lists();
+      if (l.counts[c] < maxCached) {
+        Block* b = static_cast<Block*>(p);
+        b->next = l.heads[c];
+        l.heads[c] = b;
+        l.counts[c]++;
+        return;
+      }
+    }
+    ::operator delete(p);
+  }
+
+  /**
+   * @return Number of frames allocated by the calling thread from recycled
+   * blocks.
+   */
+  static std::size_t hits() { return hitCount(); }
+
+ private:
+  static const std::size_t granularity = 64;
+  static const std::size_t classes = 16;
+  static const std::size_t maxCached = 32;
+
+  struct Block {
+    Block* next;
+  };
+
+  enum Status { unused, alive, dead };
+
+  struct Lists {
+    Lists() { status() = alive; }
+    ~Lists() {
+      status() = dead;
+      for (Block* head : heads) {
+        while (head) {
+          Block* next = head->next;
+          ::operator delete(head);
+          head = next;
+        }
+      }
+    }
+
+    Block* heads[classes] = {};
+    std::size_t counts[classes] = {};
+  };
+
+  static std::size_t sizeClass(std::size_t size) {
+    return (size + granularity - 1) / granularity - 1;
+  }
+
+  /* trivially destructible, hence valid after the lists are destroyed */
+  static Status& status() {
+    thread_local Status s = unused;
+    return s;
+  }
+
+  static std::size_t& hitCount() {
+    thread_local std::size_t n = 0;
+    return n;
+  }
+
+  static Lists& lists() {
+    thread_local Lists l;
+    return l;
+  }
+};
+
+/**
+ * Base of promise types, allocating frames from the FramePool.
+ */
+struct PooledFrame {
+  static void* operator new(std::size_t size) {
+    return FramePool::allocate(size);
+  }
+  static void operator delete(void* p, std::size_t size) {
+    FramePool::deallocate(p, size);
+  }
+};
+
+/**
+ * Awaiter for values that are available, or never will be.
+ * On failure, `Fail` stores the result of the coroutine before it is
+ * destroyed.
+ */
+template <typename Ref, typename Present, typename Value, typename Fail>
+struct ShortCircuit {
+  Ref ref;
+
+  bool await_ready() const { return Present()(ref); }
+
+  template <typename Promise>
+  void await_suspend(std::coroutine_handle<Promise> h) {
+    Fail()(std::forward<Ref>(ref), h.promise());
+    h.destroy();
+  }
+
+  decltype(auto) await_resume() { return Value()(std::forward<Ref>(ref)); }
+};
+
+struct IsJust {
+  template <typename M> bool operator()(const M& m) const {
+    return m.isJust();
+  }
+};
+
+struct IsRight {
+  template <typename E> bool operator()(const E& e) const {
+    return e.isRight();
+  }
+};
+
+struct GetJust {
+  template <typename A> A& operator()(Maybe<A>& m) const { return m.get(); }
+  template <typename A> const A& operator()(const Maybe<A>& m) const {
+    return m.get();
+  }
+  template <typename A> A operator()(Maybe<A>&& m) const {
+    return std::move(m.get());
+  }
+};
+
+struct GetRight {
+  template <typename A, typename B> B& operator()(Either<A, B>& e) const {
+    return e.asRight();
+  }
+  template <typename A, typename B>
+  const B& operator()(const Either<A, B>& e) const {
+    return e.asRight();
+  }
+  template <typename A, typename B> B operator()(Either<A, B>&& e) const {
+    return std::move(e.asRight());
+  }
+};
+
+struct ReturnNothing {
+  template <typename M, typename Promise>
+  void operator()(M&&, Promise& p) const {
+    p.return_value(Nothing);
+  }
+};
+
+struct ReturnLeft {
+  template <typename A, typename B, typename Promise>
+  void operator()(Either<A, B>& e, Promise& p) const {
+    p.returnLeft(e.asLeft());
+  }
+  template <typename A, typename B, typename Promise>
+  void operator()(const Either<A, B>& e, Promise& p) const {
+    p.returnLeft(e.asLeft());
+  }
+  template <typename A, typename B, typename Promise>
+  void operator()(Either<A, B>&& e, Promise& p) const {
+    p.returnLeft(std::move(e.asLeft()));
+  }
+};
+
+/**
+ * Return object of Maybe and Either coroutines.
+ *
+ * Lives on the stack of the caller until the coroutine completed (which it
+ * does before returning to the caller), then converts to the result.
+ */
+template <typename R> class CoReturn {
+ public:
+  template <typename Promise> explicit CoReturn(Promise& p) { p.out = this; }
+
+  CoReturn(const CoReturn&) = delete;
+  CoReturn(CoReturn&&) = delete;
+
+  operator R() {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+    assert(result.isJust());
+    return std::move(result.get());
+  }
+
+  Maybe<R> result;
+  std::exception_ptr error;
+};
+
+/**
+ * Destroys the frame on completion, unless it is left to the caller.
+ */
+struct FinalSuspend {
+  bool keep;
+
+  bool await_ready() const noexcept { return !keep; }
+  void await_suspend(std::coroutine_handle<>) const noexcept {}
+  void await_resume() const noexcept {}
+};
+
+template <typename Derived, typename R> struct CoPromise : PooledFrame {
+  CoReturn<R>* out = nullptr;
+
+  CoReturn<R> get_return_object() {
+    return CoReturn<R>(static_cast<Derived&>(*this));
+  }
+  std::suspend_never initial_suspend() noexcept { return {}; }
+  FinalSuspend final_suspend() noexcept {
+    return {MARJORAM_CALLER_RELEASES_FAILED_FRAME && out->error};
+  }
+  /* rethrown by the conversion, once the frame is destroyed */
+  void unhandled_exception() { out->error = std::current_exception(); }
+};
+
+template <typename T>
+struct MaybePromise : CoPromise<MaybePromise<T>, Maybe<T>> {
+  MaybePromise() {}
+
+  template <typename U> void return_value(U&& u) {
+    this->out->result.emplace(std::forward<U>(u));
+  }
+
+  template <typename M, typename = std::enable_if_t<std::is_same<
+                            Maybe<typename std::decay_t<M>::value_type>,
+                            std::decay_t<M>>::value>>
+  auto await_transform(M&& m) {
+    return ShortCircuit<M&&, IsJust, GetJust, ReturnNothing>{
+        std::forward<M>(m)};
+  }
+};
+
+template <typename E, typename T>
+struct EitherPromise : CoPromise<EitherPromise<E, T>, Either<E, T>> {
+  EitherPromise() {}
+
+  template <typename U> void return_value(U&& u) {
+    this->out->result.emplace(std::forward<U>(u));
+  }
+
+  template <typename U> void returnLeft(U&& u) {
+    this->out->result.emplace(Left, std::forward<U>(u));
+  }
+
+  template <typename M,
+            typename = std::enable_if_t<std::is_same<
+                Either<typename std::decay_t<M>::left_type,
+                       typename std::decay_t<M>::right_type>,
+                std::decay_t<M>>::value>>
+  auto await_transform(M&& m) {
+    return ShortCircuit<M&&, IsRight, GetRight, ReturnLeft>{
+        std::forward<M>(m)};
+  }
+};
+
+template <typename A> struct LazyPromise : PooledFrame {
+  /* shared by all copies of the returned Lazy, owns the frame */
+  struct State {
+    ~State() {
+      if (handle) {
+        handle.destroy();
+      }
+    }
+
+    std::coroutine_handle<LazyPromise> handle;
+    Maybe<A> value;
+    std::exception_ptr error;
+  };
+
+  struct Resume {
+    A operator()() const {
+      if (!state->handle.done()) {
+        state->handle.resume();
+      }
+      if (state->error) {
+        std::rethrow_exception(state->error);
+      }
+      return take(state->value.get(), std::is_copy_constructible<A>());
+    }
+
+    static A take(A& a, std::true_type /* copyable */) { return a; }
+    static A take(A& a, std::false_type /* copyable */) { return std::move(a); }
+
+    std::shared_ptr<State> state;
+  };
+
+  template <typename L> struct Force {
+    L& lazy;
+
+    bool await_ready() const noexcept { return true; }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    decltype(auto) await_resume() { return lazy.get(); }
+  };
+
+  Lazy<A> get_return_object() {
+    auto s = std::make_shared<State>();
+    s->handle = std::coroutine_handle<LazyPromise>::from_promise(*this);
+    state = s.get();
+    return Lazy<A>(std::function<A()>(Resume{s}));
+  }
+  std::suspend_always initial_suspend() noexcept { return {}; }
+  std::suspend_always final_suspend() noexcept { return {}; }
+  void unhandled_exception() { state->error = std::current_exception(); }
+
+  template <typename U> void return_value(U&& u) {
+    state->value.emplace(std::forward<U>(u));
+  }
+
+  template <typename U> Force<Lazy<U>> await_transform(Lazy<U>& la) {
+    return {la};
+  }
+  template <typename U>
+  Force<const Lazy<U>> await_transform(const Lazy<U>& la) {
+    return {la};
+  }
+
+  State* state = nullptr;
+};
+}  // namespace detail
+// @}
+}  // namespace ma
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+namespace std {
+template <typename T, typename... Args>
+struct coroutine_traits<ma::Maybe<T>, Args...> {
+  using promise_type = ma::detail::MaybePromise<T>;
+};
+
+template <typename E, typename T, typename... Args>
+struct coroutine_traits<ma::Either<E, T>, Args...> {
+  using promise_type = ma::detail::EitherPromise<E, T>;
+};
+
+template <typename A, typename... Args>
+struct coroutine_traits<ma::Lazy<A>, Args...> {
+  using promise_type = ma::detail::LazyPromise<A>;
+};
+}  // namespace std
+#endif
+#endif
@@ -5,6 +5,8 @@
 #include "nothing.hpp"
 #include "utils.h"
 #include <algorithm>
+#include <cstddef>
+#include <functional>
 #include <type_traits>
 
 namespace ma {
@@ -42,6 +44,23 @@ namespace ma {
 template <typename A, typename B> class EitherIterator;
 template <typename A, typename B> class ConstEitherIterator;
 template <typename A> class Maybe;
+template <typename A> class Just_t;
+template <typename A, typename B> class Right_t;
+template <typename A, typename B> class Either;
+
+namespace detail {
+/* result type of flatMap: `Either<A, C>` for a step returning
+ * `Either<Never, C>` */
+template <typename A, typename R> struct FlatMappedEither { using type = R; };
+
+template <typename A, typename C>
+struct FlatMappedEither<A, Either<Never, C>> {
+  using type = Either<A, C>;
+};
+
+template <typename A, typename R>
+using FlatMappedEither_t = typename FlatMappedEither<A, R>::type;
+}  // namespace detail
 
 /**
  * Either monad.
@@ -57,6 +76,15 @@ template <typename A> class Maybe;
  *
  * Terminology: If an Either<A, B> contains an A value, we say it has a left
  * value, similarly for B and right.
+ *
+ * `B` may be an lvalue reference: `Either<A, B&>` holds a pointer to the
+ * referenced object, which must outlive it.
+ *
+ * Either side may be Never, which has no values: `Either<Never, B>` has the
+ * size of `B` and its combinators test no side at run time. It converts
+ * implicitly to any `Either<A, B>`, such that `flatMap` into a fallible step
+ * widens the left type; likewise `Either<A, Never>` converts to any
+ * `Either<A, B>`.
  */
 template <typename A, typename B>
 class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
@@ -64,8 +92,13 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
   using impl = detail::EitherImpl<A, B>;
   static_assert(std::is_same<std::decay_t<A>, A>::value,
                 "Either<A, B>: A must be a value type.");
-  static_assert(std::is_same<std::decay_t<B>, B>::value,
-                "Either<A, B>: B must be a value type.");
+  static_assert(std::is_same<std::decay_t<B>, B>::value ||
+                    std::is_lvalue_reference<B>::value,
+                "Either<A, B>: B must be a value type or an lvalue "
+                "reference.");
+  static_assert(!std::is_same<A, Never>::value ||
+                    !std::is_same<B, Never>::value,
+                "Either<Never, Never> has no values.");
 
  public:
   using value_type = B;
@@ -111,6 +144,98 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
   Either(RightSide /* selects overload */, Args&&... args)
       : impl(Right, std::forward<Args>(args)...) {}
 
+  /**
+   * Widen `Either<Never, B>`, holding a `B`.
+   */
+  template <typename AA = A, typename BB = B,
+            typename = std::enable_if_t<!std::is_same<AA, Never>::value &&
+                                        !std::is_same<BB, Never>::value>>
+  Either(const Either<Never, B>& other) : impl(Right, other.asRight()) {}
+
+  template <typename AA = A, typename BB = B,
+            typename = std::enable_if_t<!std::is_same<AA, Never>::value &&
+                                        !std::is_same<BB, Never>::value>>
+  Either(Either<Never, B>&& other)
+      : impl(Right, std::forward<B>(other.asRight())) {}
+
+  /**
+   * Widen `Either<A, Never>`, holding an `A`.
+   */
+  template <typename AA = A, typename BB = B,
+            typename = std::enable_if_t<!std::is_same<AA, Never>::value &&
+                                        !std::is_same<BB, Never>::value>>
+  Either(const Either<A, Never>& other) : impl(Left, other.asLeft()) {}
+
+  template <typename AA = A, typename BB = B,
+            typename = std::enable_if_t<!std::is_same<AA, Never>::value &&
+                                        !std::is_same<BB, Never>::value>>
+  Either(Either<A, Never>&& other) : impl(Left, std::move(other.asLeft())) {}
+
+#ifdef MARJORAM_HAS_STD_VARIANT
+  /**
+   * Copy the alternative of `v`, index 0 being left.
+   */
+  template <typename V, typename = std::enable_if_t<std::is_same<
+                            std::decay_t<V>, std::variant<A, B>>::value>>
+  Either(V&& v)
+      : Either(v.index() == 0
+                   ? Either(Left, std::get<0>(std::forward<V>(v)))
+                   : Either(Right, std::get<1>(std::forward<V>(v)))) {}
+
+  /**
+   * @return `std::variant` holding a copy of the value, left at index 0.
+   */
+  std::variant<A, B> toVariant() const& {
+    if (isRight()) {
+      return std::variant<A, B>(std::in_place_index<1>, asRight());
+    }
+    return std::variant<A, B>(std::in_place_index<0>, asLeft());
+  }
+
+  /**
+   * @return `std::variant` holding the moved value, left at index 0.
+   */
+  std::variant<A, B> toVariant() && {
+    if (isRight()) {
+      return std::variant<A, B>(std::in_place_index<1>, std::move(asRight()));
+    }
+    return std::variant<A, B>(std::in_place_index<0>, std::move(asLeft()));
+  }
+#endif
+
+#ifdef MARJORAM_HAS_STD_EXPECTED
+  /**
+   * Copy the value of `e` as right, or its error as left.
+   */
+  template <typename E, typename = std::enable_if_t<std::is_same<
+                            std::decay_t<E>, std::expected<B, A>>::value>,
+            typename = void>
+  Either(E&& e)
+      : Either(e.has_value() ? Either(Right, *std::forward<E>(e))
+                             : Either(Left, std::forward<E>(e).error())) {}
+
+  /**
+   * @return `std::expected` holding a copy of the right value, or of the left
+   * value as error.
+   */
+  std::expected<B, A> toExpected() const& {
+    if (isRight()) {
+      return std::expected<B, A>(std::in_place, asRight());
+    }
+    return std::expected<B, A>(std::unexpect, asLeft());
+  }
+
+  /**
+   * @return `std::expected` holding the moved value.
+   */
+  std::expected<B, A> toExpected() && {
+    if (isRight()) {
+      return std::expected<B, A>(std::in_place, std::move(asRight()));
+    }
+    return std::expected<B, A>(std::unexpect, std::move(asLeft()));
+  }
+#endif
+
   /**
    * Checks whether an `A` is stored.
    * @return true if this `Either<A, B>` contains an A value.
@@ -175,14 +300,15 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
    * Applies supplied function to stored `B` value if one is available.
    *
    * @param fb Function object. `F::operator()` when called with `const B&`
-   * has return type `Either<A, C>`.
+   * has return type `Either<A, C>`, or `Either<Never, C>` which is widened.
    *
    * @return If this object contains a `B` value, the result of `fb(b)` is
    * stored in the returned either. Otherwise, the pre-existing `A` value is
    * copied into the return value.
    */
   template <typename Fb>
-  auto flatMap(Fb fb) const& -> std::result_of_t<Fb(const B&)> {
+  auto flatMap(Fb fb) const&
+      -> detail::FlatMappedEither_t<A, std::result_of_t<Fb(const B&)>> {
     using C = typename std::result_of_t<Fb(const B&)>::right_type;
     if (isRight()) {
       return fb(asRight());
@@ -200,7 +326,9 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
    * stored in the returned either. Otherwise, the pre-existing `A` value is
    * copied into the return value.
    */
-  template <typename Fb> auto flatMap(Fb fb) & -> std::result_of_t<Fb(B&)> {
+  template <typename Fb>
+  auto flatMap(Fb fb) &
+      -> detail::FlatMappedEither_t<A, std::result_of_t<Fb(B&)>> {
     using C = typename std::result_of_t<Fb(B&)>::right_type;
     if (isRight()) {
       return fb(asRight());
@@ -219,10 +347,12 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
    * stored in the returned either. Otherwise, the pre-existing `A` value is
    * copied into the return value.
    */
-  template <typename Fb> auto flatMap(Fb fb) && -> std::result_of_t<Fb(B)> {
+  template <typename Fb>
+  auto flatMap(Fb fb) &&
+      -> detail::FlatMappedEither_t<A, std::result_of_t<Fb(B)>> {
     using C = typename std::result_of_t<Fb(B)>::right_type;
     if (isRight()) {
-      return fb(std::move(asRight()));
+      return fb(std::forward<B>(asRight()));
     }
     return Either<A, C>(Left, asLeft());
   }
@@ -283,7 +413,7 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
   auto map(Fb fb) && -> Either<A, std::result_of_t<Fb(B)>> {
     using C = typename std::result_of_t<Fb(B)>;
     if (isRight()) {
-      return Either<A, C>(Right, fb(std::move(asRight())));
+      return Either<A, C>(Right, fb(std::forward<B>(asRight())));
     }
     return Either<A, C>(Left, asLeft());
   }
@@ -415,6 +545,42 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
     return fold([](const auto&) { return false; }, pred);
   }
 
+  /**
+   * Calls `f` with the right value, statically known to be present, if there
+   * is one.
+   *
+   * @param f Function object, called with `Right_t<A, const B&>`.
+   * @return true iff `f` was called.
+   */
+  template <typename F> bool ifRight(F f) const& {
+    if (isRight()) {
+      f(Right_t<A, const B&>(Right, asRight()));
+    }
+    return isRight();
+  }
+
+  /**
+   * Calls `f` with `Right_t<A, B&>` referring to the right value, if there is
+   * one.
+   */
+  template <typename F> bool ifRight(F f) & {
+    if (isRight()) {
+      f(Right_t<A, B&>(Right, asRight()));
+    }
+    return isRight();
+  }
+
+  /**
+   * Calls `f` with `Right_t<A, B>` holding the moved right value, if there is
+   * one.
+   */
+  template <typename F> bool ifRight(F f) && {
+    if (isRight()) {
+      f(Right_t<A, B>(Right, std::forward<B>(asRight())));
+    }
+    return isRight();
+  }
+
   /**
    * Returns contained right value or given default value.
    */
@@ -560,6 +726,201 @@ class MARJORAM_NODISCARD Either : private detail::EitherImpl<A, B> {
   ConstEitherIterator<A, B> cend() const { return {*this, false}; }
 };
 
+/**
+ * Either statically known to hold a right value.
+ *
+ * Passed on by `Either::ifRight`. Its combinators do not test the side and
+ * return statically right types where possible; it converts implicitly to
+ * `Either<A, B>`.
+ *
+ * `B` may be an lvalue reference, the Right_t then refers to an object that
+ * must outlive it.
+ */
+template <typename A, typename B> class MARJORAM_NODISCARD Right_t {
+  static_assert(std::is_same<std::decay_t<A>, A>::value,
+                "Right_t<A, B>: A must be a value type.");
+  static_assert(std::is_same<std::decay_t<B>, B>::value ||
+                    std::is_lvalue_reference<B>::value,
+                "Right_t<A, B>: B must be a value type or an lvalue "
+                "reference.");
+
+ public:
+  using value_type = B;
+  using left_type = A;
+  using right_type = B;
+
+  /**
+   * Construct the right value in place.
+   */
+  template <typename... Args>
+  Right_t(RightSide /* selects overload */, Args&&... args)
+      : value_(std::forward<Args>(args)...) {}
+
+  /**
+   * @return Either holding a copy of the right value.
+   */
+  operator Either<A, B>() const& { return Either<A, B>(Right, value_); }
+
+  /**
+   * @return Either holding the moved right value.
+   */
+  operator Either<A, B>() && {
+    return Either<A, B>(Right, std::forward<B>(value_));
+  }
+
+  /**
+   * @return false.
+   */
+  static constexpr bool isLeft() { return false; }
+
+  /**
+   * @return true.
+   */
+  static constexpr bool isRight() { return true; }
+
+  /**
+   * @return reference to the right value.
+   */
+  const B& asRight() const { return value_; }
+
+  /**
+   * @return reference to the right value.
+   */
+  B& asRight() { return value_; }
+
+  /**
+   * @return `fb(b)`, `fa` is not used.
+   */
+  template <typename Fa, typename Fb>
+  auto fold(Fa /* fa */, Fb fb) const -> std::result_of_t<Fb(const B&)> {
+    return fb(value_);
+  }
+
+  /**
+   * @return `fb(b)`.
+   */
+  template <typename Fb>
+  auto flatMap(Fb fb) const& -> std::result_of_t<Fb(const B&)> {
+    return fb(value_);
+  }
+
+  template <typename Fb> auto flatMap(Fb fb) & -> std::result_of_t<Fb(B&)> {
+    return fb(value_);
+  }
+
+  template <typename Fb> auto flatMap(Fb fb) && -> std::result_of_t<Fb(B)> {
+    return fb(std::forward<B>(value_));
+  }
+
+  /**
+   * @return `Right_t<A, C>` containing the result of `fb(b)`.
+   */
+  template <typename Fb>
+  auto map(Fb fb) const& -> Right_t<A, std::result_of_t<Fb(const B&)>> {
+    return Right_t<A, std::result_of_t<Fb(const B&)>>(Right, fb(value_));
+  }
+
+  template <typename Fb>
+  auto map(Fb fb) & -> Right_t<A, std::result_of_t<Fb(B&)>> {
+    return Right_t<A, std::result_of_t<Fb(B&)>>(Right, fb(value_));
+  }
+
+  template <typename Fb>
+  auto map(Fb fb) && -> Right_t<A, std::result_of_t<Fb(B)>> {
+    return Right_t<A, std::result_of_t<Fb(B)>>(Right,
+                                               fb(std::forward<B>(value_)));
+  }
+
+  /**
+   * @return Right_t with left type `C`, the result type of `fa`, holding
+   * the right value.
+   */
+  template <typename Fa>
+  auto leftMap(Fa /* fa */) const&
+      -> Right_t<std::result_of_t<Fa(const A&)>, B> {
+    return Right_t<std::result_of_t<Fa(const A&)>, B>(Right, value_);
+  }
+
+  template <typename Fa>
+  auto leftMap(Fa /* fa */) && -> Right_t<std::result_of_t<Fa(A)>, B> {
+    return Right_t<std::result_of_t<Fa(A)>, B>(Right,
+                                               std::forward<B>(value_));
+  }
+
+  /**
+   * @return result of applying `pred` to the right value.
+   */
+  template <class Predicate> bool exists(Predicate pred) const {
+    return pred(value_);
+  }
+
+  /**
+   * @return The right value, `dflt` is not used.
+   */
+  const B& getOrElse(const B& /* dflt */) const { return value_; }
+
+  /**
+   * @return Copy of the right value, `fa` is not used.
+   */
+  template <typename Fa> B recover(Fa /* fa */) const { return value_; }
+
+  /**
+   * @return Just_t holding a copy of the right value.
+   */
+  Just_t<B> toMaybe() const& { return Just_t<B>(InitInPlace, value_); }
+
+  /**
+   * @return Just_t holding the moved right value.
+   */
+  Just_t<B> toMaybe() && {
+    return Just_t<B>(InitInPlace, std::forward<B>(value_));
+  }
+
+  /**
+   * @return True if the right value compares equal to argument `c`.
+   */
+  template <typename C> bool contains(const C& c) const { return value_ == c; }
+
+  std::remove_reference_t<B>* begin() { return &value_; }
+  const std::remove_reference_t<B>* begin() const { return &value_; }
+
+  std::remove_reference_t<B>* end() { return &value_ + 1; }
+  const std::remove_reference_t<B>* end() const { return &value_ + 1; }
+
+ private:
+  B value_;
+};
+
+template <typename A, typename B>
+bool operator==(const Right_t<A, B>& lhs, const Right_t<A, B>& rhs) {
+  return lhs.asRight() == rhs.asRight();
+}
+
+template <typename A, typename B>
+bool operator!=(const Right_t<A, B>& lhs, const Right_t<A, B>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename A, typename B>
+bool operator==(const Either<A, B>& lhs, const Right_t<A, B>& rhs) {
+  return lhs.isRight() && lhs.asRight() == rhs.asRight();
+}
+
+template <typename A, typename B>
+bool operator==(const Right_t<A, B>& lhs, const Either<A, B>& rhs) {
+  return rhs == lhs;
+}
+
+template <typename A, typename B>
+bool operator!=(const Either<A, B>& lhs, const Right_t<A, B>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename A, typename B>
+bool operator!=(const Right_t<A, B>& lhs, const Either<A, B>& rhs) {
+  return !(lhs == rhs);
+}
+
 template <typename A, typename B>
 bool operator==(const Either<A, B>& rhs, const Either<A, B>& lhs) {
   if (rhs.isLeft()) {
@@ -574,6 +935,52 @@ bool operator!=(const Either<A, B>& rhs, const Either<A, B>& lhs) {
   return !(rhs == lhs);
 }
 
+/**
+ * Total order, left values first, then values of the same side by
+ * `operator<`.
+ */
+template <typename A, typename B>
+bool operator<(const Either<A, B>& lhs, const Either<A, B>& rhs) {
+  if (lhs.isRight() != rhs.isRight()) {
+    return lhs.isLeft();
+  }
+  if (lhs.isRight()) {
+    return lhs.asRight() < rhs.asRight();
+  }
+  return lhs.asLeft() < rhs.asLeft();
+}
+
+template <typename A, typename B>
+bool operator>(const Either<A, B>& lhs, const Either<A, B>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename A, typename B>
+bool operator<=(const Either<A, B>& lhs, const Either<A, B>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename A, typename B>
+bool operator>=(const Either<A, B>& lhs, const Either<A, B>& rhs) {
+  return !(lhs < rhs);
+}
+
+#ifdef MARJORAM_HAS_THREE_WAY_COMPARISON
+template <typename A, typename B>
+auto operator<=>(const Either<A, B>& lhs, const Either<A, B>& rhs)
+    -> std::common_comparison_category_t<
+        std::compare_three_way_result_t<A>,
+        std::compare_three_way_result_t<std::decay_t<B>>> {
+  if (lhs.isRight() != rhs.isRight()) {
+    return lhs.isRight() <=> rhs.isRight();
+  }
+  if (lhs.isRight()) {
+    return lhs.asRight() <=> rhs.asRight();
+  }
+  return lhs.asLeft() <=> rhs.asLeft();
+}
+#endif
+
 /**
  * Right-biased iterator. Allows mutable access to the right value of an Either.
  *
@@ -594,7 +1001,7 @@ template <typename A, typename B> class EitherIterator {
   using difference_type = size_t;
   using value_type = B;
   using reference = B&;
-  using pointer = B*;
+  using pointer = std::remove_reference_t<B>*;
 
   EitherIterator(Either<A, B>& Mb, bool start)
       : Mb_(Mb), start_(start && Mb_.isRight()) {}
@@ -632,7 +1039,7 @@ template <typename A, typename B> class ConstEitherIterator {
   using difference_type = size_t;
   using value_type = const B;
   using reference = const B&;
-  using pointer = const B*;
+  using pointer = const std::remove_reference_t<B>*;
 
   ConstEitherIterator(const Either<A, B>& Mb, bool start)
       : Mb_(Mb), start_(start && Mb_.isRight()) {}
@@ -661,3 +1068,28 @@ template <typename A, typename B> class ConstEitherIterator {
 };
 // @}
 }  // namespace ma
+
+namespace std {
+/**
+ * Hash of Never, which has no values to hash, such that Either with a Never
+ * side is hashable.
+ */
+template <> struct hash<ma::Never> {
+  std::size_t operator()(const ma::Never& /* never called */) const {
+    return 0;
+  }
+};
+
+/**
+ * Hash of Either, mixing the side with the hash of the value.
+ */
+template <typename A, typename B> struct hash<ma::Either<A, B>> {
+  std::size_t operator()(const ma::Either<A, B>& e) const {
+    if (e.isRight()) {
+      return ma::detail::hashCombine(
+          1, std::hash<std::decay_t<B>>()(e.asRight()));
+    }
+    return ma::detail::hashCombine(0, std::hash<A>()(e.asLeft()));
+  }
+};
+}  // namespace std
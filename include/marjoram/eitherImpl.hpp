@@ -3,6 +3,8 @@
 #include <algorithm>
 #include <cassert>
 #include <new>
+#include <type_traits>
+#include <utility>
 
 namespace ma {
 /**
@@ -27,6 +29,20 @@ struct RightSide {
  */
 static const RightSide Right;
 
+/**
+ * Uninhabited type, no value of it can be constructed.
+ *
+ * Marks the alternative of an Either that cannot occur: `Either<Never, B>`
+ * always holds a `B` and `Either<A, Never>` always holds an `A`. Both store
+ * no tag, and the side is known at compile time.
+ */
+class Never {
+  Never() {}
+};
+
+inline bool operator==(const Never&, const Never&) { return true; }
+inline bool operator!=(const Never&, const Never&) { return false; }
+
 namespace detail {
 
 enum EitherSide : char { left, right };
@@ -183,5 +199,159 @@ template <typename Left_t, typename Right_t> class EitherImpl {
   using storage_t = typename std::aligned_union<1, Left_t, Right_t>::type;
   storage_t storage;
 };
+
+/**
+ * Storage of an Either whose other side is Never: a `T` on the side `Side`,
+ * without tag.
+ */
+template <typename T, typename Side> class OneSidedImpl {
+  using Other =
+      std::conditional_t<std::is_same<Side, LeftSide>::value, RightSide,
+                         LeftSide>;
+
+ public:
+  /**
+   * Construct containing the value.
+   */
+  template <typename... Args>
+  explicit OneSidedImpl(Side /* selects overload */, Args&&... args) {
+    new (&storage) T(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Construct from Never, unreachable.
+   */
+  explicit OneSidedImpl(Other /* selects overload */, const Never&) {
+    assert(false && "Never has no values");
+  }
+
+  ~OneSidedImpl() { value().~T(); }
+
+  OneSidedImpl(const OneSidedImpl& rhs) { new (&storage) T(rhs.value()); }
+
+  OneSidedImpl(OneSidedImpl&& rhs) noexcept {
+    new (&storage) T(std::move(rhs.value()));
+  }
+
+  OneSidedImpl& operator=(const OneSidedImpl& rhs) {
+    if (this != &rhs) {
+      value().~T();
+      new (&storage) T(rhs.value());
+    }
+    return *this;
+  }
+
+  OneSidedImpl& operator=(OneSidedImpl&& rhs) noexcept {
+    if (this != &rhs) {
+      value().~T();
+      new (&storage) T(std::move(rhs.value()));
+    }
+    return *this;
+  }
+
+ protected:
+  /**
+   * Side of the value, a constant.
+   */
+  static constexpr EitherSide side =
+      std::is_same<Side, LeftSide>::value ? left : right;
+
+  T& value() { return *reinterpret_cast<T*>(&storage); }
+  const T& value() const { return *reinterpret_cast<const T*>(&storage); }
+
+  /* the other side, unreachable */
+  Never& never() const {
+    assert(false && "Never has no values");
+    return *reinterpret_cast<Never*>(const_cast<storage_t*>(&storage));
+  }
+
+ private:
+  using storage_t = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+  storage_t storage;
+};
+
+/**
+ * Right value, the left side is Never.
+ */
+template <typename Right_t>
+class EitherImpl<Never, Right_t> : public OneSidedImpl<Right_t, RightSide> {
+  using base = OneSidedImpl<Right_t, RightSide>;
+
+ public:
+  using base::base;
+
+  Right_t& asRight() { return base::value(); }
+  const Right_t& asRight() const { return base::value(); }
+
+  Never& asLeft() const { return base::never(); }
+};
+
+/**
+ * Left value, the right side is Never.
+ */
+template <typename Left_t>
+class EitherImpl<Left_t, Never> : public OneSidedImpl<Left_t, LeftSide> {
+  using base = OneSidedImpl<Left_t, LeftSide>;
+
+ public:
+  using base::base;
+
+  Left_t& asLeft() { return base::value(); }
+  const Left_t& asLeft() const { return base::value(); }
+
+  Never& asRight() const { return base::never(); }
+};
+
+/**
+ * Union of a type and a reference, stored as a pointer.
+ */
+template <typename Left_t, typename Right_t>
+class EitherImpl<Left_t, Right_t&> : public EitherImpl<Left_t, Right_t*> {
+  using base = EitherImpl<Left_t, Right_t*>;
+
+ public:
+  /**
+   * Construct containing left type.
+   */
+  template <typename... Args>
+  explicit EitherImpl(LeftSide /* selects overload */, Args&&... args)
+      : base(Left, std::forward<Args>(args)...) {}
+
+  /**
+   * Construct referring to `r`.
+   */
+  explicit EitherImpl(RightSide /* selects overload */, Right_t& r)
+      : base(Right, &r) {}
+
+  /* would refer to a temporary */
+  EitherImpl(RightSide, std::remove_const_t<Right_t>&&) = delete;
+
+  /**
+   * Returns the referenced object.
+   *
+   * Undefined behavior if this either does not contain a reference.
+   */
+  Right_t& asRight() const { return *base::asRight(); }
+};
+
+/**
+ * Reference, the left side is Never.
+ */
+template <typename Right_t>
+class EitherImpl<Never, Right_t&> : public EitherImpl<Never, Right_t*> {
+  using base = EitherImpl<Never, Right_t*>;
+
+ public:
+  explicit EitherImpl(LeftSide /* selects overload */, const Never& never)
+      : base(Left, never) {}
+
+  explicit EitherImpl(RightSide /* selects overload */, Right_t& r)
+      : base(Right, &r) {}
+
+  /* would refer to a temporary */
+  EitherImpl(RightSide, std::remove_const_t<Right_t>&&) = delete;
+
+  Right_t& asRight() const { return *base::asRight(); }
+};
 }  // namespace detail
 }  // namespace ma
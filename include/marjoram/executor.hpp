@@ -0,0 +1,267 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ma {
+/**
+ * @defgroup Executor Executor
+ * @addtogroup Executor
+ * @{
+ * Executors run function objects, possibly on other threads.
+ *
+ * An executor is any object with a member function
+ * ~~~
+ * void execute(std::function<void()> f);
+ * ~~~
+ * that eventually calls `f` exactly once.
+ */
+
+/**
+ * Runs functions immediately on the calling thread.
+ */
+struct InlineExecutor {
+  void execute(std::function<void()> f) const { f(); }
+};
+
+/**
+ * Runs functions on a fixed number of worker threads, in submission order.
+ *
+ * Functions submitted before destruction are run before the workers exit.
+ */
+class ThreadPool {
+ public:
+  /**
+   * @param threads Number of worker threads, at least one.
+   */
+  explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) {
+    for (unsigned i = 0; i < (threads ? threads : 1); ++i) {
+      workers_.emplace_back([this]() { work(); });
+    }
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wakeup_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Schedules `f` to run on one of the workers.
+   */
+  void execute(std::function<void()> f) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push_back(std::move(f));
+    }
+    wakeup_.notify_one();
+  }
+
+  /**
+   * @return Number of worker threads.
+   */
+  std::size_t size() const { return workers_.size(); }
+
+ private:
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      wakeup_.wait(lock, [this]() { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      auto f = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      f();
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::deque<std::function<void()>> queue_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+
+/**
+ * Runs functions on a fixed number of worker threads, each with its own
+ * queue.
+ *
+ * Functions submitted by a worker go to its own queue, which it processes in
+ * last in, first out order; idle workers steal the oldest functions from the
+ * queues of others. This keeps nested parallelism local to a worker, and
+ * threads waiting for results of functions they submitted can help with
+ * `tryRunOne` instead of blocking.
+ *
+ * Functions submitted before destruction are run before the workers exit.
+ */
+class WorkStealingPool {
+ public:
+  /**
+   * @param threads Number of worker threads, at least one.
+   */
+  explicit WorkStealingPool(
+      unsigned threads = std::thread::hardware_concurrency()) {
+    const unsigned n = threads ? threads : 1;
+    for (unsigned i = 0; i < n; ++i) {
+      queues_.emplace_back(new Queue());
+    }
+    for (unsigned i = 0; i < n; ++i) {
+      workers_.emplace_back([this, i]() { work(i); });
+    }
+  }
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+  ~WorkStealingPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex_);
+      stop_ = true;
+    }
+    wakeup_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * @return Pool shared by the whole program, with one worker per hardware
+   * thread.
+   */
+  static WorkStealingPool& shared() {
+    static WorkStealingPool pool;
+    return pool;
+  }
+
+  /**
+   * Schedules `f` to run on one of the workers.
+   */
+  void execute(std::function<void()> f) {
+    const Worker& self = current();
+    const std::size_t index =
+        self.pool == this ? self.index
+                          : next_.fetch_add(1, std::memory_order_relaxed) %
+                                queues_.size();
+    /* pairs with the wait in `work`: either side sees the other */
+    pending_.fetch_add(1, std::memory_order_seq_cst);
+    {
+      std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+      queues_[index]->jobs.push_back(std::move(f));
+    }
+    if (sleepers_.load(std::memory_order_seq_cst)) {
+      std::lock_guard<std::mutex> lock(sleepMutex_);
+      wakeup_.notify_one();
+    }
+  }
+
+  /**
+   * Runs one queued function on the calling thread, if there is any.
+   * @return true iff a function was run.
+   */
+  bool tryRunOne() {
+    const Worker& self = current();
+    std::function<void()> f;
+    if (!(self.pool == this && popNewest(self.index, f)) && !steal(f)) {
+      return false;
+    }
+    pending_.fetch_sub(1, std::memory_order_relaxed);
+    f();
+    return true;
+  }
+
+  /**
+   * @return Number of worker threads.
+   */
+  std::size_t size() const { return workers_.size(); }
+
+ private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> jobs;
+  };
+
+  /* identifies the pool and queue of worker threads */
+  struct Worker {
+    const WorkStealingPool* pool;
+    std::size_t index;
+  };
+
+  static Worker& current() {
+    thread_local Worker worker{nullptr, 0};
+    return worker;
+  }
+
+  bool popNewest(std::size_t index, std::function<void()>& f) {
+    Queue& q = *queues_[index];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (q.jobs.empty()) {
+      return false;
+    }
+    f = std::move(q.jobs.back());
+    q.jobs.pop_back();
+    return true;
+  }
+
+  bool steal(std::function<void()>& f) {
+    const std::size_t start = next_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < queues_.size(); ++i) {
+      Queue& q = *queues_[(start + i) % queues_.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.jobs.empty()) {
+        f = std::move(q.jobs.front());
+        q.jobs.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void work(std::size_t index) {
+    current() = Worker{this, index};
+    while (true) {
+      if (tryRunOne()) {
+        continue;
+      }
+      sleepers_.fetch_add(1, std::memory_order_seq_cst);
+      std::unique_lock<std::mutex> lock(sleepMutex_);
+      wakeup_.wait(lock, [this]() {
+        return stop_ || pending_.load(std::memory_order_seq_cst);
+      });
+      sleepers_.fetch_sub(1, std::memory_order_relaxed);
+      if (stop_ && !pending_.load()) {
+        return;
+      }
+    }
+  }
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  /* round robin among queues for functions submitted from outside */
+  std::atomic<std::size_t> next_{0};
+  /* number of queued functions, possibly including some being queued */
+  std::atomic<std::size_t> pending_{0};
+  std::atomic<int> sleepers_{0};
+  std::mutex sleepMutex_;
+  std::condition_variable wakeup_;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+// @}
+}  // namespace ma
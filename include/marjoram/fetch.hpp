@@ -0,0 +1,392 @@
+#pragma once
+
+#include "either.hpp"
+#include "maybe.hpp"
+#include "reader.hpp"
+#include "utils.h"
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ma {
+/**
+ * @defgroup Fetch Fetch
+ * @addtogroup Fetch
+ * @{
+ * Batched and deduplicated data access.
+ *
+ * ~~~
+ * template <class A> class Fetch;
+ * ~~~
+ *
+ * A `Fetch<A>` computes an `A` from data requested from data sources. Fetches
+ * composed with `zip` or `sequence` are independent: their requests are
+ * collected, deduplicated, and sent to each source in a single `multiGet`
+ * call per round. Fetches composed with `flatMap` depend on each other and
+ * need another round.
+ *
+ * A data source is any type providing
+ * ~~~
+ * using key_type = ...;    // hashable, equality comparable
+ * using value_type = ...;  // copyable
+ * std::vector<value_type> multiGet(const std::vector<key_type>& keys) const;
+ * ~~~
+ * where `multiGet` returns the values for `keys`, in order. Missing values can
+ * be represented with `value_type = Maybe<...>`.
+ *
+ * Each FetchRun caches the values obtained, so a key is requested from its
+ * source at most once per run.
+ *
+ * Example
+ * -------
+ * Following the dependency injection pattern of `test/test_reader.cxx`:
+ * ~~~
+ * Reader<RepositoryRef, Fetch<User>> getUser(int id) {
+ *   return Reader<RepositoryRef, Fetch<User>>(
+ *       [id](RepositoryRef r) { return fetch(r.get().users, id); });
+ * }
+ *
+ * Reader<RepositoryRef, Fetch<std::vector<std::string>>> emails(
+ *     std::vector<int> ids) {
+ *   return Reader<RepositoryRef, Fetch<std::vector<std::string>>>(
+ *       [ids](RepositoryRef r) {
+ *         return traverse(ids, [r](int id) {
+ *           return getUser(id).run(r).map([](User u) { return u.email; });
+ *         });
+ *       });
+ * }
+ *
+ * // a single call to multiGet, whatever the number of ids
+ * std::vector<std::string> all = runFetch(emails(ids)).run(repository);
+ * ~~~
+ */
+
+template <typename A> class Fetch;
+class FetchRun;
+
+/**
+ * Either the next step of a fetch blocked on requests, or its result.
+ */
+template <typename A> using FetchStep = Either<Fetch<A>, A>;
+
+/**
+ * Computation of an `A` from data sources.
+ */
+template <typename A> class Fetch {
+ public:
+  using value_type = A;
+
+  static_assert(std::is_same<std::decay_t<A>, A>::value,
+                "Fetch<A>: A must be a value type.");
+
+  /**
+   * @param step Function advancing the computation until it is either done,
+   * or blocked on requests it issued to the run.
+   */
+  explicit Fetch(std::function<FetchStep<A>(FetchRun&)> step)
+      : step_(std::move(step)) {}
+
+  /**
+   * @return Fetch resulting in `a` without requesting anything.
+   */
+  static Fetch<A> pure(A a) {
+    return Fetch<A>([a](FetchRun&) { return FetchStep<A>(Right, a); });
+  }
+
+  /**
+   * Advances the computation, see the constructor.
+   */
+  FetchStep<A> step(FetchRun& run) const { return step_(run); }
+
+  /**
+   * @param f Function object, `F::operator()` called with `A` returns `B`.
+   * @return Fetch of `f` applied to the result.
+   */
+  template <typename F> Fetch<std::result_of_t<F(A)>> map(F f) const {
+    using B = std::result_of_t<F(A)>;
+    const Fetch<A> self = *this;
+    return Fetch<B>([self, f](FetchRun& run) {
+      FetchStep<A> s = self.step(run);
+      if (s.isLeft()) {
+        return FetchStep<B>(Left, s.asLeft().map(f));
+      }
+      return FetchStep<B>(Right, f(std::move(s.asRight())));
+    });
+  }
+
+  /**
+   * @param f Function object, `F::operator()` called with `A` returns
+   * `Fetch<B>`.
+   * @return Fetch of `B`, whose requests are issued once the result of this
+   * fetch is known.
+   */
+  template <typename F> std::result_of_t<F(A)> flatMap(F f) const {
+    using FetchB = std::result_of_t<F(A)>;
+    using B = typename FetchB::value_type;
+    static_assert(std::is_same<FetchB, Fetch<B>>::value,
+                  "Fetch::flatMap f type mismatch.");
+    const Fetch<A> self = *this;
+    return Fetch<B>([self, f](FetchRun& run) {
+      FetchStep<A> s = self.step(run);
+      if (s.isLeft()) {
+        return FetchStep<B>(Left, s.asLeft().flatMap(f));
+      }
+      return f(std::move(s.asRight())).step(run);
+    });
+  }
+
+ private:
+  std::function<FetchStep<A>(FetchRun&)> step_;
+};
+
+/**
+ * Cache and pending requests of one evaluation of fetches.
+ *
+ * Values obtained are cached for the lifetime of the run; running several
+ * fetches with the same run shares the cache.
+ */
+class FetchRun {
+ public:
+  FetchRun() {}
+  FetchRun(const FetchRun&) = delete;
+  FetchRun& operator=(const FetchRun&) = delete;
+
+  /**
+   * Runs `f` to completion, in as many rounds as its dependencies require.
+   * @return Result of `f`.
+   */
+  template <typename A> A run(const Fetch<A>& f) {
+    FetchStep<A> s = f.step(*this);
+    while (s.isLeft()) {
+      const bool requested = flush();
+      assert(requested && "Fetch blocked without requests");
+      (void)requested;
+      ++rounds_;
+      s = s.asLeft().step(*this);
+    }
+    return std::move(s.asRight());
+  }
+
+  /**
+   * @return Number of rounds of requests issued so far.
+   */
+  std::size_t rounds() const { return rounds_; }
+
+  /**
+   * @return Cached value of `key` from `source`. If there is none, requests
+   * it for the next round and returns Nothing.
+   */
+  template <typename Source>
+  Maybe<typename Source::value_type> lookup(
+      const Source& source, const typename Source::key_type& key) {
+    SourceBatch<Source>& b = batch(source);
+    auto it = b.cache.find(key);
+    if (it == b.cache.end()) {
+      b.cache.emplace(key, Nothing);
+      b.pending.push_back(key);
+      return Nothing;
+    }
+    return it->second;
+  }
+
+ private:
+  struct Batch {
+    virtual ~Batch() {}
+    /* @return true iff there were pending requests */
+    virtual bool flush() = 0;
+  };
+
+  template <typename Source> struct SourceBatch : Batch {
+    using K = typename Source::key_type;
+    using V = typename Source::value_type;
+
+    explicit SourceBatch(const Source& s) : source(s) {}
+
+    bool flush() override {
+      if (pending.empty()) {
+        return false;
+      }
+      std::vector<V> values = source.multiGet(pending);
+      assert(values.size() == pending.size());
+      for (std::size_t i = 0; i < pending.size(); ++i) {
+        cache.find(pending[i])->second.emplace(std::move(values[i]));
+      }
+      pending.clear();
+      return true;
+    }
+
+    const Source& source;
+    /* Nothing while requested */
+    std::unordered_map<K, Maybe<V>, detail::PoolHash<K>> cache;
+    std::vector<K> pending;
+  };
+
+  /* sources are identified by address and type */
+  using BatchKey = std::pair<const void*, std::type_index>;
+
+  template <typename Source> SourceBatch<Source>& batch(const Source& source) {
+    auto& b = batches_[BatchKey(&source, typeid(Source))];
+    if (!b) {
+      b.reset(new SourceBatch<Source>(source));
+    }
+    return static_cast<SourceBatch<Source>&>(*b);
+  }
+
+  bool flush() {
+    bool requested = false;
+    for (auto& b : batches_) {
+      requested = b.second->flush() || requested;
+    }
+    return requested;
+  }
+
+  std::unordered_map<BatchKey, std::unique_ptr<Batch>,
+                     detail::PoolHash<BatchKey>>
+      batches_;
+  std::size_t rounds_ = 0;
+};
+
+/**
+ * @return Fetch of the value of `key` in `source`.
+ *
+ * `source` must outlive the runs of the fetch.
+ */
+template <typename Source>
+Fetch<typename Source::value_type> fetch(const Source& source,
+                                         typename Source::key_type key) {
+  using V = typename Source::value_type;
+  const Source* s = &source;
+  return Fetch<V>([s, key](FetchRun& run) {
+    Maybe<V> v = run.lookup(*s, key);
+    if (v.isNothing()) {
+      return FetchStep<V>(Left, fetch(*s, key));
+    }
+    return FetchStep<V>(Right, std::move(v.get()));
+  });
+}
+
+namespace detail {
+template <typename A> Fetch<A> resume(FetchStep<A>&& s) {
+  if (s.isLeft()) {
+    return std::move(s.asLeft());
+  }
+  return Fetch<A>::pure(std::move(s.asRight()));
+}
+
+template <typename... As, std::size_t... Is>
+Fetch<std::tuple<As...>> zip(std::index_sequence<Is...>,
+                             std::tuple<Fetch<As>...> fs) {
+  using Result = std::tuple<As...>;
+  return Fetch<Result>([fs](FetchRun& run) {
+    /* all fetches take their step, so that their requests share the round */
+    std::tuple<FetchStep<As>...> steps{std::get<Is>(fs).step(run)...};
+    bool done = true;
+    (void)std::initializer_list<int>{
+        (done = done && std::get<Is>(steps).isRight(), 0)...};
+    if (done) {
+      return FetchStep<Result>(Right,
+                               std::move(std::get<Is>(steps).asRight())...);
+    }
+    return FetchStep<Result>(
+        Left, zip(std::index_sequence<Is...>(),
+                  std::make_tuple(resume(std::move(std::get<Is>(steps)))...)));
+  });
+}
+
+/*
+ * @param done Results of completed fetches, in order.
+ * @param blocked Remaining fetches, with the index of their result.
+ */
+template <typename A>
+Fetch<std::vector<A>> sequence(
+    std::vector<Maybe<A>> done,
+    std::vector<std::pair<std::size_t, Fetch<A>>> blocked) {
+  return Fetch<std::vector<A>>([done, blocked](FetchRun& run) {
+    std::vector<Maybe<A>> results = done;
+    std::vector<std::pair<std::size_t, Fetch<A>>> still;
+    for (const auto& b : blocked) {
+      FetchStep<A> s = b.second.step(run);
+      if (s.isLeft()) {
+        still.emplace_back(b.first, std::move(s.asLeft()));
+      } else {
+        results[b.first].emplace(std::move(s.asRight()));
+      }
+    }
+    if (!still.empty()) {
+      return FetchStep<std::vector<A>>(
+          Left, sequence(std::move(results), std::move(still)));
+    }
+    std::vector<A> values;
+    values.reserve(results.size());
+    for (auto& r : results) {
+      values.push_back(std::move(r.get()));
+    }
+    return FetchStep<std::vector<A>>(Right, std::move(values));
+  });
+}
+}  // namespace detail
+
+/**
+ * @return Fetch of the results of independent fetches `fs`, whose requests
+ * are batched together.
+ */
+template <typename... As>
+Fetch<std::tuple<As...>> zip(Fetch<As>... fs) {
+  return detail::zip(std::index_sequence_for<As...>(),
+                     std::make_tuple(std::move(fs)...));
+}
+
+/**
+ * @return Fetch of the results of independent fetches `fs` in order, whose
+ * requests are batched together.
+ */
+template <typename A> Fetch<std::vector<A>> sequence(std::vector<Fetch<A>> fs) {
+  std::vector<std::pair<std::size_t, Fetch<A>>> blocked;
+  blocked.reserve(fs.size());
+  for (std::size_t i = 0; i < fs.size(); ++i) {
+    blocked.emplace_back(i, std::move(fs[i]));
+  }
+  std::vector<Maybe<A>> done(fs.size());
+  return detail::sequence(std::move(done), std::move(blocked));
+}
+
+/**
+ * @return `sequence` of `f` applied to each element of `ts`.
+ */
+template <typename T, typename F>
+auto traverse(const std::vector<T>& ts, F f)
+    -> Fetch<std::vector<typename std::result_of_t<F(const T&)>::value_type>> {
+  using A = typename std::result_of_t<F(const T&)>::value_type;
+  std::vector<Fetch<A>> fs;
+  fs.reserve(ts.size());
+  for (const auto& t : ts) {
+    fs.push_back(f(t));
+  }
+  return sequence(std::move(fs));
+}
+
+/**
+ * @return Result of `f`, obtained with a new FetchRun.
+ */
+template <typename A> A runFetch(const Fetch<A>& f) {
+  FetchRun run;
+  return run.run(f);
+}
+
+/**
+ * @return Reader running the fetch produced by `r`.
+ */
+template <typename Env, typename A>
+Reader<Env, A> runFetch(Reader<Env, Fetch<A>> r) {
+  return Reader<Env, A>([r](const Env& env) { return runFetch(r.run(env)); });
+}
+// @}
+}  // namespace ma
@@ -0,0 +1,370 @@
+#pragma once
+
+#include "either.hpp"
+#include "maybe.hpp"
+#include "nothing.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ma {
+/**
+ * @addtogroup Binary
+ * @{
+ * Maybe and Either with a documented layout, to be placed in shared memory.
+ *
+ * `Maybe` and `Either` store their values through `boost::optional` and
+ * `std::aligned_union`, whose layouts are unspecified. `FlatMaybe<T>` and
+ * `FlatEither<A, B>` are standard-layout and trivially copyable for
+ * standard-layout, trivially copyable `T`, `A` and `B`, verified by
+ * `static_assert`: a tag byte at offset 0, 1 for Just or right, then the
+ * value at offset `alignof` of the payload, with absent values zero filled.
+ * This is the layout of Encoding, such that the bytes of a flat value are
+ * its binary encoding when the payload is not itself a Maybe or Either.
+ *
+ * `FlatMaybe<T&>` refers to an object through an OffsetPtr, relative to its
+ * own address: it remains valid when the segment holding both is mapped at
+ * another address, or copied as a whole.
+ *
+ * Example
+ * -------
+ * ~~~
+ * struct Slot {
+ *   FlatEither<ErrorCode, Quote> result;
+ * };
+ * auto* slot = static_cast<Slot*>(segment);
+ * slot->result = FlatEither<ErrorCode, Quote>(computeQuote());
+ * ~~~
+ */
+
+/**
+ * Pointer stored as the distance to its own address.
+ *
+ * Standard-layout but not trivially copyable: copies recompute the distance.
+ */
+template <typename T> class OffsetPtr {
+ public:
+  OffsetPtr() : offset_(null) { checkLayout(); }
+  OffsetPtr(T* p) : offset_(distanceTo(p)) { checkLayout(); }
+  OffsetPtr(const OffsetPtr& rhs) : offset_(distanceTo(rhs.get())) {
+    checkLayout();
+  }
+
+  OffsetPtr& operator=(const OffsetPtr& rhs) {
+    offset_ = distanceTo(rhs.get());
+    return *this;
+  }
+
+  OffsetPtr& operator=(T* p) {
+    offset_ = distanceTo(p);
+    return *this;
+  }
+
+  T* get() const {
+    if (offset_ == null) {
+      return nullptr;
+    }
+    return reinterpret_cast<T*>(const_cast<char*>(self()) + offset_);
+  }
+
+  T& operator*() const { return *get(); }
+  T* operator->() const { return get(); }
+  explicit operator bool() const { return offset_ != null; }
+
+ private:
+  /* an object cannot start one byte past a pointer to itself */
+  static constexpr std::ptrdiff_t null = 1;
+
+  static void checkLayout() {
+    static_assert(std::is_standard_layout<OffsetPtr>::value,
+                  "OffsetPtr<T> must be standard-layout.");
+    static_assert(sizeof(OffsetPtr) == sizeof(std::ptrdiff_t),
+                  "OffsetPtr<T> holds the distance only.");
+  }
+
+  const char* self() const { return reinterpret_cast<const char*>(this); }
+
+  std::ptrdiff_t distanceTo(const T* p) const {
+    if (!p) {
+      return null;
+    }
+    return reinterpret_cast<const char*>(p) - self();
+  }
+
+  std::ptrdiff_t offset_;
+};
+
+/**
+ * Standard-layout Maybe of a standard-layout, trivially copyable `T`.
+ */
+template <typename T> class FlatMaybe {
+  static_assert(std::is_trivially_copyable<T>::value &&
+                    std::is_standard_layout<T>::value,
+                "FlatMaybe<T>: T must be trivially copyable and "
+                "standard-layout.");
+
+ public:
+  using value_type = T;
+
+  FlatMaybe() : tag_(0), bytes_{} { clear(); }
+  FlatMaybe(Nothing_t /* Nothing */) : FlatMaybe() {}
+
+  FlatMaybe(const T& t) : FlatMaybe() {
+    tag_ = 1;
+    value_ = t;
+  }
+
+  /**
+   * Copies the value of `m`, if any.
+   */
+  explicit FlatMaybe(const Maybe<T>& m) : FlatMaybe() {
+    if (m.isJust()) {
+      tag_ = 1;
+      value_ = m.get();
+    }
+  }
+
+  bool isJust() const { return tag_ != 0; }
+  bool isNothing() const { return tag_ == 0; }
+
+  /**
+   * Returns the value.
+   *
+   * Undefined behavior if this is Nothing.
+   */
+  const T& get() const {
+    assert(isJust());
+    return value_;
+  }
+
+  T& get() {
+    assert(isJust());
+    return value_;
+  }
+
+  const T& getOrElse(const T& dflt) const { return isJust() ? value_ : dflt; }
+
+  /**
+   * @return Copy as a Maybe.
+   */
+  Maybe<T> toMaybe() const {
+    if (isJust()) {
+      return Maybe<T>(value_);
+    }
+    return Nothing;
+  }
+
+ private:
+  static void checkLayout() {
+    static_assert(std::is_standard_layout<FlatMaybe>::value,
+                  "FlatMaybe<T> must be standard-layout.");
+    static_assert(std::is_trivially_copyable<FlatMaybe>::value,
+                  "FlatMaybe<T> must be trivially copyable.");
+    static_assert(offsetof(FlatMaybe, value_) == alignof(T),
+                  "FlatMaybe<T>: the value follows the tag, aligned.");
+  }
+
+  /* zero fills, padding included */
+  void clear() {
+    checkLayout();
+    std::memset(static_cast<void*>(this), 0, sizeof(*this));
+  }
+
+  std::uint8_t tag_;
+  union {
+    T value_;
+    unsigned char bytes_[sizeof(T)];
+  };
+};
+
+/**
+ * Standard-layout Maybe referring to an object through an OffsetPtr.
+ *
+ * The object must outlive it and be in the same segment when the segment is
+ * mapped at several addresses.
+ */
+template <typename T> class FlatMaybe<T&> {
+ public:
+  using value_type = T&;
+
+  FlatMaybe() { checkLayout(); }
+  FlatMaybe(Nothing_t /* Nothing */) { checkLayout(); }
+  FlatMaybe(T& t) : ptr_(&t) { checkLayout(); }
+
+  /* would refer to a temporary */
+  FlatMaybe(std::remove_const_t<T>&&) = delete;
+
+  bool isJust() const { return bool(ptr_); }
+  bool isNothing() const { return !ptr_; }
+
+  /**
+   * Returns the referenced object.
+   *
+   * Undefined behavior if this is Nothing.
+   */
+  T& get() const {
+    assert(isJust());
+    return *ptr_;
+  }
+
+  T& getOrElse(T& dflt) const { return isJust() ? *ptr_ : dflt; }
+
+  /**
+   * @return Maybe referring to the same object.
+   */
+  Maybe<T&> toMaybe() const {
+    if (isJust()) {
+      return Maybe<T&>(*ptr_);
+    }
+    return Nothing;
+  }
+
+ private:
+  static void checkLayout() {
+    static_assert(std::is_standard_layout<FlatMaybe>::value,
+                  "FlatMaybe<T&> must be standard-layout.");
+    static_assert(sizeof(FlatMaybe) == sizeof(OffsetPtr<T>),
+                  "FlatMaybe<T&> holds the offset pointer only.");
+  }
+
+  OffsetPtr<T> ptr_;
+};
+
+/**
+ * Standard-layout Either of standard-layout, trivially copyable `A` and `B`.
+ */
+template <typename A, typename B> class FlatEither {
+  static_assert(std::is_trivially_copyable<A>::value &&
+                    std::is_standard_layout<A>::value &&
+                    std::is_trivially_copyable<B>::value &&
+                    std::is_standard_layout<B>::value,
+                "FlatEither<A, B>: A and B must be trivially copyable and "
+                "standard-layout.");
+
+ public:
+  using left_type = A;
+  using right_type = B;
+
+  FlatEither(LeftSide /* selects overload */, const A& a)
+      : tag_(0), bytes_{} {
+    clear();
+    left_ = a;
+  }
+
+  FlatEither(RightSide /* selects overload */, const B& b)
+      : tag_(0), bytes_{} {
+    clear();
+    tag_ = 1;
+    right_ = b;
+  }
+
+  /**
+   * Copies the value of `e`.
+   */
+  explicit FlatEither(const Either<A, B>& e) : tag_(0), bytes_{} {
+    clear();
+    if (e.isRight()) {
+      tag_ = 1;
+      right_ = e.asRight();
+    } else {
+      left_ = e.asLeft();
+    }
+  }
+
+  bool isLeft() const { return tag_ == 0; }
+  bool isRight() const { return tag_ != 0; }
+
+  /**
+   * Returns the left value.
+   *
+   * Undefined behavior if this holds a right value.
+   */
+  const A& asLeft() const {
+    assert(isLeft());
+    return left_;
+  }
+
+  A& asLeft() {
+    assert(isLeft());
+    return left_;
+  }
+
+  /**
+   * Returns the right value.
+   *
+   * Undefined behavior if this holds a left value.
+   */
+  const B& asRight() const {
+    assert(isRight());
+    return right_;
+  }
+
+  B& asRight() {
+    assert(isRight());
+    return right_;
+  }
+
+  /**
+   * @return Copy as an Either.
+   */
+  Either<A, B> toEither() const {
+    if (isRight()) {
+      return Either<A, B>(Right, right_);
+    }
+    return Either<A, B>(Left, left_);
+  }
+
+ private:
+  static void checkLayout() {
+    static_assert(std::is_standard_layout<FlatEither>::value,
+                  "FlatEither<A, B> must be standard-layout.");
+    static_assert(std::is_trivially_copyable<FlatEither>::value,
+                  "FlatEither<A, B> must be trivially copyable.");
+    static_assert(offsetof(FlatEither, left_) ==
+                      (alignof(A) < alignof(B) ? alignof(B) : alignof(A)),
+                  "FlatEither<A, B>: the value follows the tag, aligned.");
+  }
+
+  /* zero fills, padding included */
+  void clear() {
+    checkLayout();
+    std::memset(static_cast<void*>(this), 0, sizeof(*this));
+  }
+
+  std::uint8_t tag_;
+  union {
+    A left_;
+    B right_;
+    unsigned char bytes_[sizeof(A) < sizeof(B) ? sizeof(B) : sizeof(A)];
+  };
+};
+
+template <typename T>
+bool operator==(const FlatMaybe<T>& lhs, const FlatMaybe<T>& rhs) {
+  if (lhs.isNothing() || rhs.isNothing()) {
+    return lhs.isNothing() && rhs.isNothing();
+  }
+  return lhs.get() == rhs.get();
+}
+
+template <typename T>
+bool operator!=(const FlatMaybe<T>& lhs, const FlatMaybe<T>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename A, typename B>
+bool operator==(const FlatEither<A, B>& lhs, const FlatEither<A, B>& rhs) {
+  if (lhs.isLeft()) {
+    return rhs.isLeft() && lhs.asLeft() == rhs.asLeft();
+  }
+  return rhs.isRight() && lhs.asRight() == rhs.asRight();
+}
+
+template <typename A, typename B>
+bool operator!=(const FlatEither<A, B>& lhs, const FlatEither<A, B>& rhs) {
+  return !(lhs == rhs);
+}
+// @}
+}  // namespace ma
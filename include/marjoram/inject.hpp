@@ -0,0 +1,324 @@
+#pragma once
+
+#include "reader.hpp"
+#include "utils.h"
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ma {
+/**
+ * @defgroup Inject Inject
+ * @addtogroup Inject
+ * @{
+ * Dependency injection resolved at compile time.
+ *
+ * An Injector owns the components living as long as the application, and
+ * creates a Context per request holding the request scoped components as
+ * well as references to the former. Computations depending on the Context are
+ * composed from `ask<Component>()`, statically typed Readers: running them
+ * accesses the component directly, without type erasure or allocation.
+ *
+ * Example
+ * -------
+ * ~~~
+ * using App = Injector<Singleton<UserRepository>, RequestScoped<RequestId>>;
+ *
+ * auto userEmail(int id) {
+ *   return ask<UserRepository>().map(
+ *       [id](const UserRepository& users) { return users.get(id).email; });
+ * }
+ *
+ * App app(UserRepository("users.db"));
+ * auto email = userEmail(7).run(app.request(RequestId{42}));
+ * ~~~
+ */
+
+/**
+ * Component shared by all requests, owned by the Injector.
+ */
+template <typename T> struct Singleton {
+  using type = T;
+};
+
+/**
+ * Component created for every request, owned by its Context.
+ */
+template <typename T> struct RequestScoped {
+  using type = T;
+};
+
+namespace detail {
+/* index of the first `T` in `Ts`, `sizeof...(Ts)` if there is none */
+template <typename T, typename... Ts> struct TypeIndex;
+
+template <typename T> struct TypeIndex<T> {
+  static constexpr std::size_t value = 0;
+};
+
+template <typename T, typename T0, typename... Ts>
+struct TypeIndex<T, T0, Ts...> {
+  static constexpr std::size_t value =
+      std::is_same<T, T0>::value ? 0 : 1 + TypeIndex<T, Ts...>::value;
+};
+
+/* `t`, once for every element of a pack */
+template <typename, typename T> T& repeated(T& t) { return t; }
+
+/**
+ * Arguments initializing components of the same type, the others are
+ * default constructed.
+ */
+template <typename... Args> struct InjectArgs {
+  template <typename T>
+  using Index = TypeIndex<T, std::decay_t<Args>...>;
+
+  template <typename T>
+  using Has = std::integral_constant<bool, (Index<T>::value < sizeof...(Args))>;
+
+  std::tuple<Args&&...> values;
+};
+
+/**
+ * Instance of a component, initialized from InjectArgs.
+ */
+template <typename T> class Instance {
+ public:
+  template <typename... Args>
+  explicit Instance(InjectArgs<Args...>& args)
+      : Instance(typename InjectArgs<Args...>::template Has<T>(), args) {}
+
+  T& get() { return value_; }
+  const T& get() const { return value_; }
+
+ private:
+  template <typename... Args>
+  Instance(std::true_type, InjectArgs<Args...>& args)
+      : value_(std::get<InjectArgs<Args...>::template Index<T>::value>(
+            std::move(args.values))) {}
+
+  template <typename... Args>
+  Instance(std::false_type, InjectArgs<Args...>&) : value_() {}
+
+  T value_;
+};
+
+/* singletons owned by the Injector, nothing for request scoped components */
+template <typename C> class Owned;
+
+template <typename T> class Owned<Singleton<T>> : public Instance<T> {
+ public:
+  using Instance<T>::Instance;
+};
+
+template <typename T> class Owned<RequestScoped<T>> {
+ public:
+  template <typename... Args> explicit Owned(InjectArgs<Args...>&) {}
+};
+
+template <typename C, typename... Args> struct Binding {
+  Owned<C>& owned;
+  InjectArgs<Args...>& args;
+};
+
+/* components as seen by a Context */
+template <typename C> class Bound;
+
+template <typename T> class Bound<Singleton<T>> {
+ public:
+  template <typename... Args>
+  explicit Bound(const Binding<Singleton<T>, Args...>& binding)
+      : value_(&binding.owned.get()) {}
+
+  const T& get() const { return *value_; }
+
+ private:
+  T* value_;
+};
+
+template <typename T> class Bound<RequestScoped<T>> : public Instance<T> {
+ public:
+  template <typename... Args>
+  explicit Bound(const Binding<RequestScoped<T>, Args...>& binding)
+      : Instance<T>(binding.args) {}
+};
+
+/* accesses component `T` of the environment */
+template <typename T> struct Component {
+  template <typename Env> const T& operator()(const Env& env) const {
+    return referent(env).template get<T>();
+  }
+};
+}  // namespace detail
+
+template <typename... Cs> class Injector;
+
+/**
+ * Environment of a request: request scoped components and references to the
+ * singletons of the Injector that created it, which must outlive it.
+ */
+template <typename... Cs> class Context {
+ public:
+  /**
+   * @return The component of type `T`, resolved at compile time.
+   */
+  template <typename T> const T& get() const {
+    constexpr std::size_t index =
+        detail::TypeIndex<T, typename Cs::type...>::value;
+    static_assert(index < sizeof...(Cs), "Context::get: unknown component.");
+    return std::get<index>(components_).get();
+  }
+
+ private:
+  friend class Injector<Cs...>;
+
+  template <typename... Args, std::size_t... Is>
+  Context(std::tuple<detail::Owned<Cs>...>& owned,
+          detail::InjectArgs<Args...>& args, std::index_sequence<Is...>)
+      : components_(detail::Binding<Cs, Args...>{std::get<Is>(owned),
+                                                  args}...) {}
+
+  std::tuple<detail::Bound<Cs>...> components_;
+};
+
+/**
+ * Owns the singletons of an application and creates request Contexts.
+ *
+ * Type requirement:
+ * - every `C` in `Cs` is `Singleton<T>` or `RequestScoped<T>`, with distinct
+ *   `T`.
+ */
+template <typename... Cs> class Injector {
+ public:
+  /**
+   * Creates the singletons, each initialized from the argument of the same
+   * type if any, default constructed otherwise. Every argument must be of the
+   * type of a singleton, checked at compile time.
+   */
+  template <typename... Args>
+  explicit Injector(Args&&... args)
+      : Injector(detail::InjectArgs<Args...>{
+            std::forward_as_tuple(std::forward<Args>(args)...)}) {
+    static_assert(
+        detail::AllOf<detail::CountOf<Singleton<std::decay_t<Args>>,
+                                      Cs...>::value == 1 ...>::value,
+        "Injector: every argument must initialize a singleton.");
+  }
+
+  /* contexts refer to the singletons */
+  Injector(const Injector&) = delete;
+  Injector& operator=(const Injector&) = delete;
+
+  /**
+   * Creates the context of a request.
+   *
+   * Request scoped components are initialized from the argument of the same
+   * type if any, default constructed otherwise. They must be movable. Every
+   * argument must be of the type of a request scoped component, checked at
+   * compile time.
+   */
+  template <typename... Args> Context<Cs...> request(Args&&... args) {
+    static_assert(
+        detail::AllOf<detail::CountOf<RequestScoped<std::decay_t<Args>>,
+                                      Cs...>::value == 1 ...>::value,
+        "Injector::request: every argument must initialize a request scoped "
+        "component.");
+    detail::InjectArgs<Args...> injected{
+        std::forward_as_tuple(std::forward<Args>(args)...)};
+    return Context<Cs...>(owned_, injected, std::index_sequence_for<Cs...>());
+  }
+
+  /**
+   * @return The singleton of type `T`.
+   */
+  template <typename T> T& get() {
+    constexpr std::size_t index =
+        detail::TypeIndex<Singleton<T>, Cs...>::value;
+    static_assert(index < sizeof...(Cs), "Injector::get: unknown singleton.");
+    return std::get<index>(owned_).get();
+  }
+
+ private:
+  template <typename... Args>
+  explicit Injector(detail::InjectArgs<Args...>&& args)
+      : owned_(detail::repeated<Cs>(args)...) {}
+
+  std::tuple<detail::Owned<Cs>...> owned_;
+};
+
+/**
+ * Reader with a statically known function, such that composing it does not
+ * erase types.
+ *
+ * Unlike Reader, it runs with any environment `F` accepts, and the function
+ * is inlined into the caller.
+ */
+template <typename F> class Ask {
+ public:
+  explicit Ask(F f) : f_(std::move(f)) {}
+
+  /**
+   * Run the function.
+   */
+  template <typename Env> decltype(auto) run(const Env& env) const {
+    return f_(env);
+  }
+
+  /**
+   * @param g Function object, called with the result of this.
+   *
+   * @return Ask of the result of `g`.
+   */
+  template <typename G> auto map(G g) const {
+    auto f = f_;
+    return makeAsk([f, g](const auto& env) -> decltype(auto) {
+      return g(f(env));
+    });
+  }
+
+  /**
+   * @param g Function object, called with the result of this, returning an
+   * Ask or a Reader run with the same environment.
+   *
+   * @return Ask of the result of the computation returned by `g`.
+   */
+  template <typename G> auto flatMap(G g) const {
+    auto f = f_;
+    return makeAsk([f, g](const auto& env) -> decltype(auto) {
+      return g(f(env)).run(env);
+    });
+  }
+
+  /**
+   * @return Reader, which erases the type of the function.
+   */
+  template <typename A>
+  auto toReader() const
+      -> Reader<A, decltype(std::declval<const F&>()(std::declval<A>()))> {
+    using R = decltype(std::declval<const F&>()(std::declval<A>()));
+    const F f = f_;
+    return Reader<A, R>([f](const A& a) -> R { return f(a); });
+  }
+
+ private:
+  template <typename G> static Ask<G> makeAsk(G g) {
+    return Ask<G>(std::move(g));
+  }
+
+  F f_;
+};
+
+/**
+ * @return Ask reading the result of `f` called with the environment.
+ */
+template <typename F> Ask<F> asks(F f) { return Ask<F>(std::move(f)); }
+
+/**
+ * @return Ask reading component `T` of a Context, or of a reference to one.
+ */
+template <typename T> Ask<detail::Component<T>> ask() {
+  return Ask<detail::Component<T>>(detail::Component<T>());
+}
+// @}
+}  // namespace ma
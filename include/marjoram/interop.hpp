@@ -0,0 +1,95 @@
+#pragma once
+
+#include "maybe.hpp"
+#include "utils.h"
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#ifdef MARJORAM_HAS_STD_OPTIONAL
+namespace ma {
+/**
+ * @addtogroup Maybe
+ * @{
+ */
+
+/**
+ * Range of `std::optional` viewed as a range of `Maybe<T&>`.
+ *
+ * Elements are created on dereference, referring to the values of the
+ * optionals in place: nothing is copied, and the range must outlive the view.
+ */
+template <typename It> class MaybeRefRange {
+  using optional_ref = typename std::iterator_traits<It>::reference;
+  using value_ref = decltype(*std::declval<optional_ref>());
+
+ public:
+  using value_type = Maybe<value_ref>;
+
+  class iterator {
+   public:
+    using iterator_category =
+        typename std::iterator_traits<It>::iterator_category;
+    using difference_type = typename std::iterator_traits<It>::difference_type;
+    using value_type = Maybe<value_ref>;
+    using reference = Maybe<value_ref>;
+    using pointer = void;
+
+    explicit iterator(It it) : it_(it) {}
+
+    Maybe<value_ref> operator*() const {
+      optional_ref o = *it_;
+      return o ? Maybe<value_ref>(*o) : Maybe<value_ref>();
+    }
+
+    iterator& operator++() {
+      ++it_;
+      return *this;
+    }
+
+    iterator operator++(int) {
+      iterator ret(*this);
+      ++it_;
+      return ret;
+    }
+
+    bool operator==(const iterator& other) const { return it_ == other.it_; }
+    bool operator!=(const iterator& other) const { return it_ != other.it_; }
+
+   private:
+    It it_;
+  };
+
+  MaybeRefRange(It first, It last) : first_(first), last_(last) {}
+
+  iterator begin() const { return iterator(first_); }
+  iterator end() const { return iterator(last_); }
+
+  std::size_t size() const { return std::distance(first_, last_); }
+
+  /**
+   * @return Element `i`, for random access ranges.
+   */
+  Maybe<value_ref> operator[](std::size_t i) const {
+    return *iterator(std::next(first_, i));
+  }
+
+ private:
+  It first_;
+  It last_;
+};
+
+/**
+ * @return View of a range of `std::optional<T>`, such as
+ * `std::vector<std::optional<T>>`, as `Maybe<T&>`, or `Maybe<const T&>` for
+ * a const range.
+ */
+template <typename Range> auto asMaybes(Range& range) {
+  using std::begin;
+  using std::end;
+  return MaybeRefRange<decltype(begin(range))>(begin(range), end(range));
+}
+// @}
+}  // namespace ma
+#endif
@@ -1,8 +1,10 @@
 #pragma once
 
 #include "either.hpp"
+#include "profiler.hpp"
 #include <functional>
 #include <type_traits>
+#include <utility>
 
 namespace ma {
 /**
@@ -85,6 +87,15 @@ template <typename A> class Lazy {
   explicit Lazy(std::function<A()> f) : impl(Left, f) {}
   explicit Lazy(const A& a) : impl(Right, a) {}
 
+  /**
+   * @param f Function that will be called exactly once when `get` is called
+   * the first time.
+   * @param label Label reported by the profiler.
+   */
+  Lazy(std::function<A()> f, const LazyLabel& label) : impl(Left, f) {
+    labeled(label);
+  }
+
   Lazy(const Lazy&) = default;
   Lazy& operator=(const Lazy&) = default;
 
@@ -100,6 +111,32 @@ template <typename A> class Lazy {
     return *this;
   }
 
+  /**
+   * Attaches a label to this node, which the profiler reports whenever this
+   * node is evaluated. Has no effect unless `MARJORAM_PROFILE_LAZY` is defined.
+   *
+   * @see Profiler
+   */
+  Lazy& labeled(const LazyLabel& label) & {
+#ifdef MARJORAM_PROFILE_LAZY
+    label_ = label;
+#else
+    (void)label;
+#endif
+    return *this;
+  }
+
+  /**
+   * Attaches a label to this node, which the profiler reports whenever this
+   * node is evaluated. Has no effect unless `MARJORAM_PROFILE_LAZY` is defined.
+   *
+   * @see Profiler
+   */
+  Lazy labeled(const LazyLabel& label) && {
+    labeled(label);
+    return std::move(*this);
+  }
+
   /**
    * @return true iff has been evaluated.
    */
@@ -111,7 +148,7 @@ template <typename A> class Lazy {
    */
   A& get() {
     if (impl.isLeft()) {
-      impl = storage_t(Right, impl.asLeft()());
+      evaluate();
     }
     return impl.asRight();
   }
@@ -122,7 +159,7 @@ template <typename A> class Lazy {
    */
   const A& get() const {
     if (impl.isLeft()) {
-      impl = storage_t(Right, impl.asLeft()());
+      evaluate();
     }
     return impl.asRight();
   }
@@ -132,6 +169,8 @@ template <typename A> class Lazy {
    * result of composing `g` with `f`, essentially `Lazy<T>(g(f()))`.
    *
    * @param g Function object.
+   * @param label Label reported by the profiler, by default the name of the
+   * composition and the location of the caller.
    *
    * Type requirement:
    * - `G::operator()` when called with argument of type `A&&` has non-void
@@ -143,8 +182,11 @@ template <typename A> class Lazy {
    * reference and must persist until the first evaluation of the return
    * value.
    */
-  template <typename G> auto map(G g) const -> Lazy<std::result_of_t<G(A)>> {
-    return Lazy<std::result_of_t<G(A)>>([g, this]() { return g(get()); });
+  template <typename G>
+  auto map(G g, const LazyLabel& label = LazyLabel::caller("map")) const
+      -> Lazy<std::result_of_t<G(A)>> {
+    return Lazy<std::result_of_t<G(A)>>([g, this]() { return g(get()); },
+                                        label);
   }
 
   /**
@@ -152,6 +194,8 @@ template <typename A> class Lazy {
    * result of composing `g` with `f`, essentially `Lazy<T>(g(f()))`.
    *
    * @param g Function object.
+   * @param label Label reported by the profiler, by default the name of the
+   * composition and the location of the caller.
    *
    * Type requirement:
    * - `G::operator()` when called with argument of type `A&&` has non-void
@@ -163,9 +207,11 @@ template <typename A> class Lazy {
    * reference and must persist until the first evaluation of the return
    * value.
    */
-  template <typename G> auto map(G g) -> Lazy<std::result_of_t<G(A)>> {
+  template <typename G>
+  auto map(G g, const LazyLabel& label = LazyLabel::caller("map"))
+      -> Lazy<std::result_of_t<G(A)>> {
     return Lazy<std::result_of_t<G(A)>>(
-        [g, this]() mutable { return g(std::move(get())); });
+        [g, this]() mutable { return g(std::move(get())); }, label);
   }
 
   /**
@@ -174,6 +220,8 @@ template <typename A> class Lazy {
    * `Lazy<T>(g(f()))`.
    *
    * @param g Function object.
+   * @param label Label reported by the profiler, by default the name of the
+   * composition and the location of the caller.
    *
    * Type requirement:
    * - `G::operator()` when called with argument of type `A&&` has return type
@@ -185,12 +233,16 @@ template <typename A> class Lazy {
    * reference and must persist until the first evaluation of the return
    * value.
    */
-  template <typename G> auto flatMap(G g) const -> std::result_of_t<G(A)> {
+  template <typename G>
+  auto flatMap(G g,
+               const LazyLabel& label = LazyLabel::caller("flatMap")) const
+      -> std::result_of_t<G(A)> {
     /* we need to artificially constraint the type here */
     using R = typename std::result_of_t<G(A)>::value_type;
     static_assert(std::is_same<Lazy<R>, std::result_of_t<G(A)>>::value,
                   "Type mismatch in F for Lazy<A>::flatMap(F: A -> Lazy<R>)");
-    return std::result_of_t<G(A)>([g, this]() { return g(get()).get(); });
+    return std::result_of_t<G(A)>([g, this]() { return g(get()).get(); },
+                                  label);
   }
 
   /**
@@ -199,6 +251,8 @@ template <typename A> class Lazy {
    * `Lazy<T>(g(f()))`.
    *
    * @param g Function object.
+   * @param label Label reported by the profiler, by default the name of the
+   * composition and the location of the caller.
    *
    * Type requirement:
    * - `G::operator()` when called with argument of type `A&&` has return type
@@ -210,13 +264,15 @@ template <typename A> class Lazy {
    * reference and must persist until the first evaluation of the return
    * value.
    */
-  template <typename G> auto flatMap(G g) -> std::result_of_t<G(A)> {
+  template <typename G>
+  auto flatMap(G g, const LazyLabel& label = LazyLabel::caller("flatMap"))
+      -> std::result_of_t<G(A)> {
     /* we need to artificially constraint the type here */
     using R = typename std::result_of_t<G(A)>::value_type;
     static_assert(std::is_same<Lazy<R>, std::result_of_t<G(A)>>::value,
                   "Type mismatch in F for Lazy<A>::flatMap(F: A -> Lazy<R>)");
     return std::result_of_t<G(A)>(
-        [g, this]() mutable { return g(std::move(get())).get(); });
+        [g, this]() mutable { return g(std::move(get())).get(); }, label);
   }
 
   LazyIterator<A> begin() const { return LazyIterator<A>(*this, true); }
@@ -224,25 +280,45 @@ template <typename A> class Lazy {
 
  private:
   using storage_t = Either<std::function<A()>, A>;
+
+  void evaluate() const {
+#ifdef MARJORAM_PROFILE_LAZY
+    profiler::Scope scope(label_);
+#endif
+    impl = storage_t(Right, impl.asLeft()());
+  }
+
   mutable storage_t impl;
+#ifdef MARJORAM_PROFILE_LAZY
+  LazyLabel label_ = {nullptr, nullptr, 0};
+#endif
 };
 
 /**
  * Flattens a nested Lazy.
  * Note that the none of the underlying computations is triggered and the
  * returned lazy object is independent of the input.
+ *
+ * @param label Label reported by the profiler.
  */
-template <typename A> Lazy<A> Flatten(const Lazy<Lazy<A>>& LLa) {
-  return Lazy<A>([LLa]() { return LLa.get().get(); });
+template <typename A>
+Lazy<A> Flatten(const Lazy<Lazy<A>>& LLa,
+                const LazyLabel& label = LazyLabel::caller("Flatten")) {
+  return Lazy<A>([LLa]() { return LLa.get().get(); }, label);
 }
 
 /**
  * Flattens a nested Lazy.
  * Note that the none of the underlying computations is triggered and on
  * completion and the input is moved from.
+ *
+ * @param label Label reported by the profiler.
  */
-template <typename A> Lazy<A> Flatten(Lazy<Lazy<A>>&& LLa) {
-  return Lazy<A>([nested = std::move(LLa)]() { return nested.get().get(); });
+template <typename A>
+Lazy<A> Flatten(Lazy<Lazy<A>>&& LLa,
+                const LazyLabel& label = LazyLabel::caller("Flatten")) {
+  return Lazy<A>([nested = std::move(LLa)]() { return nested.get().get(); },
+                 label);
 }
 
 /**
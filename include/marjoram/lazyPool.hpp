@@ -0,0 +1,113 @@
+#pragma once
+
+#include "lazy.hpp"
+#include "utils.h"
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+
+namespace ma {
+/**
+ * @addtogroup Lazy
+ * @{
+ */
+
+/**
+ * Interns Lazy values by key, such that requests for the same computation
+ * share one node that is evaluated at most once.
+ *
+ * The key identifies the computation, it should consist of an identifier of
+ * the function and of its arguments, e.g. `std::tuple<std::string, int>`
+ * holding a function name and a dataset id. Keys that compare equal must
+ * describe the same pure computation.
+ *
+ * The pool only holds weak references: a node is destroyed as soon as its
+ * last user releases it, and the corresponding entry is purged from the pool
+ * eventually.
+ *
+ * Example
+ * -------
+ * ~~~
+ * LazyPool<std::tuple<std::string, int>, Index> indices;
+ * auto index = indices.intern(std::make_tuple("buildIndex", datasetId),
+ *                             [datasetId]() { return buildIndex(datasetId); });
+ * ~~~
+ *
+ * Like Lazy, the pool is not thread safe.
+ */
+template <typename Key, typename A, typename Hash = detail::PoolHash<Key>,
+          typename KeyEqual = std::equal_to<Key>>
+class LazyPool {
+ public:
+  using key_type = Key;
+  using value_type = A;
+
+  /**
+   * @return Node interned under `key`. If there is none (or all its users
+   * released it), creates a new node that evaluates `f`.
+   *
+   * @param f Function object. `F::operator()` called without arguments has
+   * return type `A`. Not called if the node already exists.
+   */
+  template <typename F>
+  std::shared_ptr<Lazy<A>> intern(const Key& key, F&& f) {
+    auto it = nodes_.find(key);
+    if (it != nodes_.end()) {
+      if (auto node = it->second.lock()) {
+        return node;
+      }
+      auto node = std::make_shared<Lazy<A>>(std::function<A()>(f));
+      it->second = node;
+      return node;
+    }
+    if (nodes_.size() >= purgeAt_) {
+      purge();
+      purgeAt_ = minPurgeAt + 2 * nodes_.size();
+    }
+    auto node = std::make_shared<Lazy<A>>(std::function<A()>(f));
+    nodes_.emplace(key, node);
+    return node;
+  }
+
+  /**
+   * @return Node interned under `key`, or Nothing if there is none alive.
+   */
+  Maybe<std::shared_ptr<Lazy<A>>> find(const Key& key) const {
+    auto it = nodes_.find(key);
+    if (it == nodes_.end() || it->second.expired()) {
+      return Nothing;
+    }
+    return it->second.lock();
+  }
+
+  /**
+   * Removes entries whose nodes have been released by all their users.
+   */
+  void purge() {
+    for (auto it = nodes_.begin(); it != nodes_.end();) {
+      if (it->second.expired()) {
+        it = nodes_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  /**
+   * @return Number of entries, including released ones not purged yet.
+   */
+  std::size_t size() const { return nodes_.size(); }
+
+ private:
+  static const std::size_t minPurgeAt = 16;
+
+  std::unordered_map<Key, std::weak_ptr<Lazy<A>>, Hash, KeyEqual> nodes_;
+  /* entries are purged once the table grows beyond this size */
+  std::size_t purgeAt_ = minPurgeAt;
+};
+// @}
+}  // namespace ma
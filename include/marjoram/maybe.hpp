@@ -4,19 +4,29 @@
 #include "nothing.hpp"
 #include "utils.h"
 #include <boost/optional/optional.hpp>
+#include <cstddef>
+#include <functional>
 #include <type_traits>
 #include <utility>
 
 namespace ma {
+template <typename A> class Maybe;
 template <typename A> class MaybeIterator;
 template <typename A> class ConstMaybeIterator;
 template <typename A, typename B> class Either;
+template <typename A> class Just_t;
+template <typename A, typename B> class Right_t;
 
-/** Tag indicating in place construction is desired */
-struct InitInPlace_t {};
+namespace detail {
+/* result type of flatMap: Maybe<B> for a function returning Just_t<B> */
+template <typename M> struct FlatMapped { using type = M; };
 
-/** Convenience constant */
-static const InitInPlace_t InitInPlace;
+template <typename B> struct FlatMapped<Just_t<B>> {
+  using type = Maybe<B>;
+};
+
+template <typename M> using FlatMapped_t = typename FlatMapped<M>::type;
+}  // namespace detail
 
 /**
  * @defgroup Maybe Maybe
@@ -112,6 +122,39 @@ template <typename A> class MARJORAM_NODISCARD Maybe {
    */
   Maybe(Maybe<A>&& ma) : impl_(std::move(ma.impl_)) { ma.reset(); };
 
+#ifdef MARJORAM_HAS_STD_OPTIONAL
+  /**
+   * Copy or move the value of `std::optional<A>` `o`, if any.
+   */
+  template <typename O, typename = std::enable_if_t<std::is_same<
+                            std::decay_t<O>, std::optional<A>>::value>>
+  Maybe(O&& o) : impl_() {
+    if (o) {
+      impl_.emplace(*std::forward<O>(o));
+    }
+  }
+
+  /**
+   * @return `std::optional` holding a copy of the value, if any.
+   */
+  std::optional<A> toOptional() const& {
+    if (isJust()) {
+      return std::optional<A>(std::in_place, get());
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * @return `std::optional` holding the moved value, if any.
+   */
+  std::optional<A> toOptional() && {
+    if (isJust()) {
+      return std::optional<A>(std::in_place, std::move(getImpl()));
+    }
+    return std::nullopt;
+  }
+#endif
+
   Maybe<A>& operator=(const Maybe<A>& ma) = default;
 
   Maybe<A>& operator=(Maybe<A>&& ma) {
@@ -141,13 +184,13 @@ template <typename A> class MARJORAM_NODISCARD Maybe {
    *
    * Type requirement:
    * - `F::operator()` when called with `const A&` argument has return type
-   *   `Maybe<B>`, where `B` is non void.
+   *   `Maybe<B>` or `Just_t<B>`, where `B` is non void.
    *
    * @return `Maybe<B>` containing the result of `f(a)` or `Nothing`.
    */
-
   template <typename F>
-  auto flatMap(F f) const& -> std::result_of_t<F(const A&)> {
+  auto flatMap(F f) const&
+      -> detail::FlatMapped_t<std::result_of_t<F(const A&)>> {
     if (isJust()) {
       return f(get());
     }
@@ -165,7 +208,8 @@ template <typename A> class MARJORAM_NODISCARD Maybe {
    *
    * @return `Maybe<B>` containing the result of `f(a)` or `Nothing`.
    */
-  template <typename F> auto flatMap(F f) & -> std::result_of_t<F(A&)> {
+  template <typename F>
+  auto flatMap(F f) & -> detail::FlatMapped_t<std::result_of_t<F(A&)>> {
     if (isJust()) {
       return f(getImpl());
     }
@@ -186,7 +230,8 @@ template <typename A> class MARJORAM_NODISCARD Maybe {
    *
    * @return `Maybe<B>` containing the result of `f(a)` or `Nothing`.
    */
-  template <typename F> auto flatMap(F f) && -> std::result_of_t<F(A)> {
+  template <typename F>
+  auto flatMap(F f) && -> detail::FlatMapped_t<std::result_of_t<F(A)>> {
     if (isJust()) {
       return f(std::move(getImpl()));
     }
@@ -392,6 +437,40 @@ template <typename A> class MARJORAM_NODISCARD Maybe {
     return map(pred).getOrElse(false);
   }
 
+  /**
+   * Calls `f` with the value, statically known to be present, if there is
+   * one.
+   *
+   * @param f Function object, called with `Just_t<const A&>`.
+   * @return true iff `f` was called.
+   */
+  template <typename F> bool ifJust(F f) const& {
+    if (isJust()) {
+      f(Just_t<const A&>(InitInPlace, get()));
+    }
+    return isJust();
+  }
+
+  /**
+   * Calls `f` with `Just_t<A&>` referring to the value, if there is one.
+   */
+  template <typename F> bool ifJust(F f) & {
+    if (isJust()) {
+      f(Just_t<A&>(InitInPlace, get()));
+    }
+    return isJust();
+  }
+
+  /**
+   * Calls `f` with `Just_t<A>` holding the moved value, if there is one.
+   */
+  template <typename F> bool ifJust(F f) && {
+    if (isJust()) {
+      f(Just_t<A>(InitInPlace, std::move(get())));
+    }
+    return isJust();
+  }
+
   MaybeIterator<A> begin() { return {*this, true}; }
   ConstMaybeIterator<A> begin() const { return {*this, true}; }
   ConstMaybeIterator<A> cbegin() const { return {*this, true}; }
@@ -407,6 +486,406 @@ template <typename A> class MARJORAM_NODISCARD Maybe {
   boost::optional<A> impl_;
 };
 
+/**
+ * Maybe of a reference.
+ *
+ * Holds a pointer to the referenced object, Nothing being the null pointer;
+ * copies refer to the same object. Functions passed to `map` and `flatMap`
+ * receive it as `A&`, so lookups returning `Maybe<A&>` do not copy.
+ *
+ * The referenced object must outlive the Maybe.
+ */
+template <typename A> class MARJORAM_NODISCARD Maybe<A&> {
+ public:
+  using value_type = A&;
+
+  /**
+   * New empty object (containing `Nothing`).
+   */
+  /* implicit */ Maybe(Nothing_t /* overload selection */) : ptr_(nullptr) {}
+
+  /**
+   * New empty object (containing `Nothing`).
+   */
+  Maybe() : ptr_(nullptr) {}
+
+  /**
+   * New instance referring to `a`.
+   */
+  Maybe(A& a) : ptr_(&a) {}
+
+  /* would refer to a temporary */
+  Maybe(std::remove_const_t<A>&& a) = delete;
+
+  /**
+   * Converts `Maybe<B&>` to `Maybe<const B&>` or a reference to a base.
+   */
+  template <typename B, typename = typename std::enable_if<
+                            std::is_convertible<B*, A*>::value>::type>
+  Maybe(const Maybe<B&>& mb) : ptr_(mb.isJust() ? &mb.get() : nullptr) {}
+
+#ifdef MARJORAM_HAS_STD_OPTIONAL
+  /**
+   * Refer to the value of `std::optional` `o`, if any, which must outlive
+   * this. A const optional is only referred to by `Maybe<const B&>`.
+   */
+  template <typename O,
+            typename = std::enable_if_t<
+                std::is_same<std::decay_t<O>,
+                             std::optional<std::remove_const_t<A>>>::value &&
+                std::is_lvalue_reference<O>::value &&
+                std::is_convertible<decltype(&*std::declval<O>()),
+                                    A*>::value>>
+  Maybe(O&& o) : ptr_(o ? &*o : nullptr) {}
+#endif
+
+  /**
+   * Refer to `a` from now on.
+   */
+  void emplace(A& a) { ptr_ = &a; }
+
+  /** Clear current reference if any. */
+  void reset() { ptr_ = nullptr; }
+
+  /**
+   * Returns result of `f(a)` if this refers to an object, otherwise returns
+   * Nothing.
+   *
+   * @param f Function object.
+   *
+   * Type requirement:
+   * - `F::operator()` when called with `A&` argument has return type
+   *   `Maybe<B>`.
+   *
+   * @return `Maybe<B>` containing the result of `f(a)` or `Nothing`.
+   */
+  template <typename F>
+  auto flatMap(F f) const -> detail::FlatMapped_t<std::result_of_t<F(A&)>> {
+    if (isJust()) {
+      return f(*ptr_);
+    }
+    return Nothing;
+  }
+
+  /**
+   * Returns maybe containing result of `f(a)` if this refers to an object,
+   * otherwise returns Nothing.
+   *
+   * @param f Function object.
+   *
+   * Type requirement:
+   * - `F::operator()` when called with `A&` argument has non-void return type
+   *   `B`, which may be a reference.
+   *
+   * @return `Maybe<B>` containing the result of `f(a)` or `Nothing`.
+   */
+  template <typename F> auto map(F f) const -> Maybe<std::result_of_t<F(A&)>> {
+    if (isJust()) {
+      return Maybe<std::result_of_t<F(A&)>>((f(*ptr_)));
+    }
+    return Nothing;
+  }
+
+  /**
+   * @return true iff this refers to an object that compares true to `b`.
+   */
+  template <typename B> bool contains(const B& b) const {
+    return isJust() && *ptr_ == b;
+  }
+
+  /**
+   * @return copy of `this` if `pred` applied to the referenced object returns
+   * `true`, Nothing otherwise.
+   */
+  template <typename Predicate> Maybe<A&> filter(Predicate pred) const {
+    if (exists(pred)) {
+      return *this;
+    }
+    return Nothing;
+  }
+
+  /**
+   * @return ma::Either containing either the reference or the argument.
+   */
+  template <class Left>
+  Either<std::decay_t<Left>, A&> toRight(Left&& left) const {
+    using Either = Either<std::decay_t<Left>, A&>;
+    if (isJust()) {
+      return Either(ma::Right, *ptr_);
+    }
+    return Either(ma::Left, std::forward<Left>(left));
+  }
+
+  /**
+   * Checks whether this instance refers to an object.
+   * @return true if this instance refers to an object.
+   */
+  bool isJust() const { return ptr_ != nullptr; }
+
+  /**
+   * Checks whether this instance does not refer to an object.
+   * @return true if this instance does not refer to an object.
+   */
+  bool isNothing() const { return !isJust(); }
+
+  /**
+   * Obtains the referenced object.
+   * Undefined behavior if this Maybe does not refer to an object.
+   * @return reference to the object.
+   */
+  A& get() const { return *ptr_; }
+
+  /**
+   * If this object refers to an object, returns it. Otherwise returns `dflt`.
+   * @return reference to the object or argument.
+   */
+  A& getOrElse(A& dflt) const { return isJust() ? *ptr_ : dflt; }
+
+  /**
+   * If this object refers to an object, returns a copy of it. Otherwise
+   * returns `dflt`.
+   */
+  std::remove_const_t<A> getOrElse(std::remove_const_t<A>&& dflt) const {
+    if (isJust()) {
+      return *ptr_;
+    }
+    return std::move(dflt);
+  }
+
+  /**
+   * Return result of applying predicate to the referenced object if there is
+   * one, false otherwise.
+   *
+   * @param pred Callable with `A&`, returns bool convertible.
+   */
+  template <class Predicate> bool exists(Predicate pred) const {
+    return isJust() && pred(*ptr_);
+  }
+
+  /**
+   * Calls `f` with `Just_t<A&>` referring to the object, if there is one.
+   *
+   * @return true iff `f` was called.
+   */
+  template <typename F> bool ifJust(F f) const {
+    if (isJust()) {
+      f(Just_t<A&>(InitInPlace, *ptr_));
+    }
+    return isJust();
+  }
+
+  A* begin() const { return ptr_; }
+  A* end() const { return ptr_ ? ptr_ + 1 : nullptr; }
+
+ private:
+  A* ptr_;
+};
+
+/**
+ * Maybe statically known to hold a value.
+ *
+ * Returned by `Present` and passed on by `Maybe::ifJust`. Its combinators do
+ * not test for presence and return statically present types where possible;
+ * it converts implicitly to `Maybe<A>`, and `Maybe::flatMap` accepts
+ * functions returning it.
+ *
+ * `A` may be an lvalue reference, the Just_t then refers to an object that
+ * must outlive it.
+ */
+template <typename A> class MARJORAM_NODISCARD Just_t {
+  static_assert(std::is_same<std::decay_t<A>, A>::value ||
+                    std::is_lvalue_reference<A>::value,
+                "Just_t<A>: A must be a value type or an lvalue reference.");
+
+ public:
+  using value_type = A;
+
+  /**
+   * Construct value in place.
+   */
+  template <class... Args>
+  Just_t(ma::InitInPlace_t, Args&&... args)
+      : value_(std::forward<Args>(args)...) {}
+
+  /**
+   * @return Maybe holding a copy of the value.
+   */
+  operator Maybe<A>() const& { return Maybe<A>(value_); }
+
+  /**
+   * @return Maybe holding the moved value.
+   */
+  operator Maybe<A>() && { return Maybe<A>(std::forward<A>(value_)); }
+
+  /**
+   * @return true.
+   */
+  static constexpr bool isJust() { return true; }
+
+  /**
+   * @return false.
+   */
+  static constexpr bool isNothing() { return false; }
+
+  /**
+   * @return reference to contained value.
+   */
+  const A& get() const { return value_; }
+
+  /**
+   * @return reference to contained value.
+   */
+  A& get() { return value_; }
+
+  /**
+   * @return reference to contained value, `dflt` is not used.
+   */
+  const A& getOrElse(const A& /* dflt */) const& { return value_; }
+
+  /**
+   * @return The contained value (along with ownership), `dflt` is not used.
+   */
+  A getOrElse(const A& /* dflt */) && { return std::forward<A>(value_); }
+
+  /**
+   * @return `f(a)`.
+   */
+  template <typename F>
+  auto flatMap(F f) const& -> std::result_of_t<F(const A&)> {
+    return f(value_);
+  }
+
+  template <typename F> auto flatMap(F f) & -> std::result_of_t<F(A&)> {
+    return f(value_);
+  }
+
+  template <typename F> auto flatMap(F f) && -> std::result_of_t<F(A)> {
+    return f(std::forward<A>(value_));
+  }
+
+  /**
+   * @return `Just_t<B>` containing the result of `f(a)`.
+   */
+  template <typename F>
+  auto map(F f) const& -> Just_t<std::result_of_t<F(const A&)>> {
+    return Just_t<std::result_of_t<F(const A&)>>(InitInPlace, f(value_));
+  }
+
+  template <typename F> auto map(F f) & -> Just_t<std::result_of_t<F(A&)>> {
+    return Just_t<std::result_of_t<F(A&)>>(InitInPlace, f(value_));
+  }
+
+  template <typename F> auto map(F f) && -> Just_t<std::result_of_t<F(A)>> {
+    return Just_t<std::result_of_t<F(A)>>(InitInPlace,
+                                          f(std::forward<A>(value_)));
+  }
+
+  /**
+   * @return true iff the value compares true to `b`.
+   */
+  template <typename B> bool contains(const B& b) const { return value_ == b; }
+
+  /**
+   * @return result of applying `pred` to the value.
+   */
+  template <class Predicate> bool exists(Predicate pred) const {
+    return pred(value_);
+  }
+
+  /**
+   * @return Maybe holding a copy of the value if `pred` applied to it returns
+   * `true`, Nothing otherwise.
+   */
+  template <typename Predicate> Maybe<A> filter(Predicate pred) const& {
+    if (pred(value_)) {
+      return Maybe<A>(value_);
+    }
+    return Nothing;
+  }
+
+  template <typename Predicate> Maybe<A> filter(Predicate pred) && {
+    if (pred(value_)) {
+      return Maybe<A>(std::forward<A>(value_));
+    }
+    return Nothing;
+  }
+
+  /**
+   * @return Right_t holding a copy of the value, `left` is not used.
+   */
+  template <class Left>
+  Right_t<std::decay_t<Left>, A> toRight(Left&& /* left */) const& {
+    return Right_t<std::decay_t<Left>, A>(ma::Right, value_);
+  }
+
+  template <class Left>
+  Right_t<std::decay_t<Left>, A> toRight(Left&& /* left */) && {
+    return Right_t<std::decay_t<Left>, A>(ma::Right, std::forward<A>(value_));
+  }
+
+  /**
+   * @return Left Either holding a copy of the value, `right` is not used.
+   */
+  template <class Right>
+  Either<A, std::decay_t<Right>> toLeft(Right&& /* right */) const& {
+    return Either<A, std::decay_t<Right>>(ma::Left, value_);
+  }
+
+  template <class Right>
+  Either<A, std::decay_t<Right>> toLeft(Right&& /* right */) && {
+    return Either<A, std::decay_t<Right>>(ma::Left, std::forward<A>(value_));
+  }
+
+  std::remove_reference_t<A>* begin() { return &value_; }
+  const std::remove_reference_t<A>* begin() const { return &value_; }
+
+  std::remove_reference_t<A>* end() { return &value_ + 1; }
+  const std::remove_reference_t<A>* end() const { return &value_ + 1; }
+
+ private:
+  A value_;
+};
+
+template <typename A>
+bool operator==(const Just_t<A>& lhs, const Just_t<A>& rhs) {
+  return lhs.get() == rhs.get();
+}
+
+template <typename A>
+bool operator!=(const Just_t<A>& lhs, const Just_t<A>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename A>
+bool operator==(const Maybe<A>& lhs, const Just_t<A>& rhs) {
+  return lhs.contains(rhs.get());
+}
+
+template <typename A>
+bool operator==(const Just_t<A>& lhs, const Maybe<A>& rhs) {
+  return rhs.contains(lhs.get());
+}
+
+template <typename A>
+bool operator!=(const Maybe<A>& lhs, const Just_t<A>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename A>
+bool operator!=(const Just_t<A>& lhs, const Maybe<A>& rhs) {
+  return !(lhs == rhs);
+}
+
+template <typename A>
+bool operator==(const Just_t<A>& /* lhs */, const Nothing_t& /* rhs */) {
+  return false;
+}
+
+template <typename A>
+bool operator==(const Nothing_t& /* lhs */, const Just_t<A>& /* rhs */) {
+  return false;
+}
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 /** Base case for `any`` */
 template <typename A> const Maybe<A>& any(const Maybe<A>& Ma) { return Ma; }
@@ -485,13 +964,10 @@ bool operator==(const ma::Nothing_t& /* lhs  */, const ma::Maybe<A>& rhs) {
 
 template <typename A>
 bool operator==(const ma::Maybe<A>& lhs, const ma::Maybe<A>& rhs) {
-  // handle case were both are nothing
-  if (lhs.isNothing() && rhs.isNothing()) {
-    return true;
+  if (lhs.isJust() != rhs.isJust()) {
+    return false;
   }
-  // otherwise values must be equal
-  return lhs.map([&rhs](const auto& a) { return rhs.contains(a); })
-      .getOrElse(false);
+  return lhs.isNothing() || lhs.get() == rhs.get();
 }
 
 template <typename A>
@@ -499,6 +975,43 @@ bool operator!=(const ma::Maybe<A>& lhs, const ma::Maybe<A>& rhs) {
   return !(lhs == rhs);
 }
 
+/**
+ * Total order, Nothing first, then values by `operator<` of `A`.
+ */
+template <typename A>
+bool operator<(const ma::Maybe<A>& lhs, const ma::Maybe<A>& rhs) {
+  if (lhs.isJust() && rhs.isJust()) {
+    return lhs.get() < rhs.get();
+  }
+  return lhs.isNothing() && rhs.isJust();
+}
+
+template <typename A>
+bool operator>(const ma::Maybe<A>& lhs, const ma::Maybe<A>& rhs) {
+  return rhs < lhs;
+}
+
+template <typename A>
+bool operator<=(const ma::Maybe<A>& lhs, const ma::Maybe<A>& rhs) {
+  return !(rhs < lhs);
+}
+
+template <typename A>
+bool operator>=(const ma::Maybe<A>& lhs, const ma::Maybe<A>& rhs) {
+  return !(lhs < rhs);
+}
+
+#ifdef MARJORAM_HAS_THREE_WAY_COMPARISON
+template <typename A>
+auto operator<=>(const ma::Maybe<A>& lhs, const ma::Maybe<A>& rhs)
+    -> std::compare_three_way_result_t<std::decay_t<A>> {
+  if (lhs.isJust() && rhs.isJust()) {
+    return lhs.get() <=> rhs.get();
+  }
+  return lhs.isJust() <=> rhs.isJust();
+}
+#endif
+
 /**
  * Immutable Iterator over Maybe.
  * @see MaybeIterator
@@ -542,7 +1055,61 @@ template <typename A> class ConstMaybeIterator {
  * Convenience constructor, copies/moves `a` into new Maybe instance.
  */
 template <typename A> Maybe<std::decay_t<A>> Just(A&& a) {
-  return Maybe<A>(std::forward<A>(a));
+  return Maybe<std::decay_t<A>>(std::forward<A>(a));
+}
+
+/**
+ * Copies/moves `a` into a new Just_t, a Maybe statically known to hold a
+ * value, which converts to Maybe.
+ */
+template <typename A> Just_t<std::decay_t<A>> Present(A&& a) {
+  return Just_t<std::decay_t<A>>(InitInPlace, std::forward<A>(a));
+}
+
+/**
+ * Looks up `key` in an associative container, such as `std::map`, without
+ * copying the mapped value.
+ *
+ * Uses `map.find(key)`, hence heterogeneous lookup if the container supports
+ * it, e.g. `std::map<std::string, V, std::less<>>` with a `const char*` key.
+ *
+ * @return Reference to the value mapped to `key`, const if `map` is, or
+ * Nothing.
+ */
+template <typename Map, typename Key>
+auto lookup(Map& map, const Key& key)
+    -> Maybe<decltype((map.find(key)->second))> {
+  auto it = map.find(key);
+  if (it == map.end()) {
+    return Nothing;
+  }
+  return it->second;
 }
+
+/* would refer into a temporary */
+template <typename Map, typename Key>
+void lookup(const Map&& map, const Key& key) = delete;
 // @}
 }  // namespace ma
+
+namespace std {
+template <typename A> struct common_type<ma::Just_t<A>, ma::Nothing_t> {
+  using type = ma::Maybe<A>;
+};
+
+template <typename A> struct common_type<ma::Nothing_t, ma::Just_t<A>> {
+  using type = ma::Maybe<A>;
+};
+
+/**
+ * Hash of Maybe, mixing presence with the hash of the value.
+ */
+template <typename A> struct hash<ma::Maybe<A>> {
+  std::size_t operator()(const ma::Maybe<A>& m) const {
+    if (m.isNothing()) {
+      return ma::detail::hashCombine(0, 0);
+    }
+    return ma::detail::hashCombine(1, std::hash<std::decay_t<A>>()(m.get()));
+  }
+};
+}  // namespace std
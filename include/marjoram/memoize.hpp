@@ -0,0 +1,173 @@
+#pragma once
+
+#include "maybe.hpp"
+#include "reader.hpp"
+#include "utils.h"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+namespace ma {
+/**
+ * @addtogroup Reader
+ * @{
+ */
+
+namespace detail {
+template <typename T>
+auto generationOf(const T& t, int) -> decltype(std::uint64_t(t.generation())) {
+  return t.generation();
+}
+template <typename T> std::uint64_t generationOf(const T&, long) { return 0; }
+
+/* address of the referent of an environment */
+struct EnvironmentAddress {
+  template <typename A> const void* operator()(const A& a) const {
+    return &referent(a);
+  }
+};
+
+/**
+ * Result of a reader, references are stored as pointers.
+ */
+template <typename R> class Memo {
+ public:
+  explicit Memo(R r) : value_(std::move(r)) {}
+  R get() const { return value_; }
+
+ private:
+  R value_;
+};
+
+template <typename R> class Memo<R&> {
+ public:
+  explicit Memo(R& r) : value_(&r) {}
+  R& get() const { return *value_; }
+
+ private:
+  R* value_;
+};
+
+/**
+ * Least recently used results by environment key, shared by all copies of a
+ * memoized reader.
+ */
+template <typename Key, typename R> class MemoCache {
+ public:
+  explicit MemoCache(std::size_t capacity)
+      : capacity_(capacity ? capacity : 1) {}
+
+  /* @return cached result for `key`, unless computed for another generation */
+  Maybe<Memo<R>> find(const Key& key, std::uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      return Nothing;
+    }
+    if (it->second->generation != generation) {
+      entries_.erase(it->second);
+      index_.erase(it);
+      return Nothing;
+    }
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->memo;
+  }
+
+  void insert(const Key& key, std::uint64_t generation, const Memo<R>& memo) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.erase(it->second);
+      index_.erase(it);
+    } else if (index_.size() == capacity_) {
+      index_.erase(entries_.back().key);
+      entries_.pop_back();
+    }
+    entries_.push_front(Entry{key, generation, memo});
+    index_.emplace(key, entries_.begin());
+  }
+
+ private:
+  struct Entry {
+    Key key;
+    std::uint64_t generation;
+    Memo<R> memo;
+  };
+
+  const std::size_t capacity_;
+  std::mutex mutex_;
+  /* most recently used first */
+  std::list<Entry> entries_;
+  std::unordered_map<Key, typename std::list<Entry>::iterator, PoolHash<Key>>
+      index_;
+};
+}  // namespace detail
+
+/**
+ * Caches the results of a reader per environment.
+ *
+ * Running a composed reader repeatedly with the same long lived environment
+ * recomputes the whole chain every time; the memoized reader returns the
+ * result computed earlier instead.
+ *
+ * The environment is identified by `key(env)`. It may provide a member
+ * function `generation()`, returning a counter that changes whenever the
+ * environment changes: results computed for other generations are discarded.
+ *
+ * Example
+ * -------
+ * ~~~
+ * Reader<ServicesRef, Permissions> permissions = memoize(
+ *     loadPermissions(), 16,
+ *     [](const ServicesRef& s) { return s.get().tenantId; });
+ * ~~~
+ *
+ * Copies of the returned reader share the cache, which is thread safe.
+ *
+ * @param capacity Maximum number of environments whose results are cached,
+ * the least recently used one is evicted first.
+ * @param key Function object, `KeyFn::operator()` called with `const A&`
+ * returns a hashable key identifying the environment.
+ */
+template <typename A, typename R, typename KeyFn>
+Reader<A, R> memoize(const Reader<A, R>& reader, std::size_t capacity,
+                     KeyFn key) {
+  using Key = std::decay_t<std::result_of_t<KeyFn(const A&)>>;
+  auto cache = std::make_shared<detail::MemoCache<Key, R>>(capacity);
+  return Reader<A, R>([reader, key, cache](const A& a) -> R {
+    const Key k = key(a);
+    const std::uint64_t generation =
+        detail::generationOf(detail::referent(a), 0);
+    auto memo = cache->find(k, generation);
+    if (memo.isJust()) {
+      return memo.get().get();
+    }
+    const detail::Memo<R> computed(reader.run(a));
+    cache->insert(k, generation, computed);
+    return computed.get();
+  });
+}
+
+/**
+ * Caches the results of a reader per environment, identified by address.
+ *
+ * Environments held by `std::reference_wrapper`, pointer or
+ * `std::shared_ptr` are identified by the address of the object referred to.
+ * Other environments are identified by their own address, which suits long
+ * lived environments only: temporaries may reuse an address.
+ *
+ * An environment destroyed while its results are cached must not be replaced
+ * by another one at the same address and generation; provide a key otherwise.
+ */
+template <typename A, typename R>
+Reader<A, R> memoize(const Reader<A, R>& reader, std::size_t capacity) {
+  return memoize(reader, capacity, detail::EnvironmentAddress());
+}
+// @}
+}  // namespace ma
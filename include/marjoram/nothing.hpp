@@ -13,5 +13,11 @@ struct Nothing_t {
  * Convenience constant.
  */
 static const Nothing_t Nothing;
+
+/** Tag indicating in place construction is desired */
+struct InitInPlace_t {};
+
+/** Convenience constant */
+static const InitInPlace_t InitInPlace;
 // @}
 }  // namespace ma
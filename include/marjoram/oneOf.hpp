@@ -0,0 +1,431 @@
+#pragma once
+
+#include "either.hpp"
+#include "utils.h"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ma {
+/**
+ * @defgroup OneOf OneOf
+ * @addtogroup OneOf
+ * @{
+ * Sum of any number of types.
+ *
+ * An instance of `OneOf<Ts...>` contains a value of exactly one of `Ts`, the
+ * alternatives. It stores a single tag of one byte, for up to 255
+ * alternatives, next to storage sized to the largest alternative; a nested
+ * `Either<A, Either<B, C>>` adds a tag and padding per level instead.
+ *
+ * `match` and `fold` call the function for the contained alternative through
+ * a table of function pointers indexed by the tag, a single indirect call
+ * whatever the number of alternatives.
+ *
+ * Example
+ * -------
+ * ~~~
+ * using Message = OneOf<Login, Logout, Ping>;
+ *
+ * Message m = Ping{};
+ * std::string name = m.fold([](const Login&) { return "login"; },
+ *                           [](const Logout&) { return "logout"; },
+ *                           [](const Ping&) { return "ping"; });
+ * ~~~
+ */
+
+/**
+ * Tag selecting alternative `I` of a OneOf.
+ */
+template <std::size_t I> struct Alternative {
+  Alternative() {}
+};
+
+template <typename... Ts> class OneOf;
+
+namespace detail {
+/* index of the first `T` in `Ts` */
+template <typename T, typename... Ts> struct IndexOf {
+  static constexpr std::size_t value = 0;
+};
+
+template <typename T, typename T0, typename... Ts>
+struct IndexOf<T, T0, Ts...> {
+  static constexpr std::size_t value =
+      std::is_same<T, T0>::value ? 0 : 1 + IndexOf<T, Ts...>::value;
+};
+
+/* OneOf with alternative `I` of `Ts` replaced by `R` */
+template <std::size_t I, typename R, typename Seq, typename... Ts>
+struct ReplaceAt;
+
+template <std::size_t I, typename R, std::size_t... Is, typename... Ts>
+struct ReplaceAt<I, R, std::index_sequence<Is...>, Ts...> {
+  using type = OneOf<std::conditional_t<Is == I, R, Ts>...>;
+};
+
+/* `Either<T0, Either<T1, ... Either<Tn-1, Tn>>>`, `T0` if there is one */
+template <typename T0, typename... Ts> struct NestedEither {
+  using type = Either<T0, typename NestedEither<Ts...>::type>;
+};
+
+template <typename T0> struct NestedEither<T0> {
+  using type = T0;
+};
+
+/* nests alternative `I` of `Ts` */
+template <std::size_t I, typename... Ts> struct Nest;
+
+template <std::size_t I, typename T0, typename... Ts>
+struct Nest<I, T0, Ts...> {
+  using type = typename NestedEither<T0, Ts...>::type;
+
+  template <typename V> static type make(V&& v) {
+    return type(Right, Nest<I - 1, Ts...>::make(std::forward<V>(v)));
+  }
+};
+
+template <typename T0, typename... Ts> struct Nest<0, T0, Ts...> {
+  using type = typename NestedEither<T0, Ts...>::type;
+
+  template <typename V> static type make(V&& v) {
+    return type(Left, std::forward<V>(v));
+  }
+};
+
+template <typename T0> struct Nest<0, T0> {
+  template <typename V> static T0 make(V&& v) {
+    return T0(std::forward<V>(v));
+  }
+};
+
+/* calls `v` with alternative `I` of `storage` */
+template <std::size_t I, typename R, typename T, typename Visitor,
+          typename Storage>
+R visitAlternative(Visitor& v, Storage& storage) {
+  using Ref = std::conditional_t<std::is_const<Storage>::value, const T&, T&>;
+  return v(std::integral_constant<std::size_t, I>(),
+           reinterpret_cast<Ref>(storage));
+}
+
+/* calls `v` with the alternative of `storage` selected by `index` */
+template <typename R, typename... Ts, typename Visitor, typename Storage,
+          std::size_t... Is>
+R visit(std::size_t index, Visitor& v, Storage& storage,
+        std::index_sequence<Is...>) {
+  using Fn = R (*)(Visitor&, Storage&);
+  static constexpr Fn table[] = {
+      &visitAlternative<Is, R, Ts, Visitor, Storage>...};
+  return table[index](v, storage);
+}
+}  // namespace detail
+
+/**
+ * Sum of the types `Ts`.
+ *
+ * Alternatives are identified by index, types occurring once in `Ts` by type
+ * as well.
+ */
+template <typename... Ts> class MARJORAM_NODISCARD OneOf {
+  static_assert(sizeof...(Ts) > 0, "OneOf<Ts...>: no alternatives.");
+  static_assert(sizeof...(Ts) <= 65535, "OneOf<Ts...>: too many alternatives.");
+
+  using tag_t = std::conditional_t<(sizeof...(Ts) < 256), std::uint8_t,
+                                   std::uint16_t>;
+  using indices = std::index_sequence_for<Ts...>;
+
+  template <typename T>
+  using IsUnique = std::integral_constant<
+      bool, detail::CountOf<std::decay_t<T>, Ts...>::value == 1>;
+
+ public:
+  /**
+   * Number of alternatives.
+   */
+  static constexpr std::size_t size = sizeof...(Ts);
+
+  /**
+   * Type of alternative `I`.
+   */
+  template <std::size_t I>
+  using type_at = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+  /**
+   * Index of alternative `T`, which occurs once in `Ts`.
+   */
+  template <typename T> static constexpr std::size_t indexOf() {
+    static_assert(detail::CountOf<T, Ts...>::value == 1,
+                  "OneOf::indexOf: T must occur exactly once.");
+    return detail::IndexOf<T, Ts...>::value;
+  }
+
+  /**
+   * Construct alternative `I` in place.
+   */
+  template <std::size_t I, typename... Args>
+  OneOf(Alternative<I> /* selects overload */, Args&&... args) : tag_(I) {
+    new (&storage_) type_at<I>(std::forward<Args>(args)...);
+  }
+
+  /**
+   * Construct the alternative of type `T`, which occurs once in `Ts`.
+   */
+  template <typename T, typename = std::enable_if_t<IsUnique<T>::value>>
+  OneOf(T&& t)
+      : OneOf(Alternative<indexOf<std::decay_t<T>>()>(), std::forward<T>(t)) {
+  }
+
+  OneOf(const OneOf& rhs) : tag_(rhs.tag_) { copyFrom(rhs); }
+
+  OneOf(OneOf&& rhs) noexcept : tag_(rhs.tag_) { moveFrom(rhs); }
+
+  OneOf& operator=(const OneOf& rhs) {
+    if (this != &rhs) {
+      destroy();
+      tag_ = rhs.tag_;
+      copyFrom(rhs);
+    }
+    return *this;
+  }
+
+  OneOf& operator=(OneOf&& rhs) noexcept {
+    if (this != &rhs) {
+      destroy();
+      tag_ = rhs.tag_;
+      moveFrom(rhs);
+    }
+    return *this;
+  }
+
+  ~OneOf() { destroy(); }
+
+  /**
+   * @return Index of the contained alternative.
+   */
+  std::size_t index() const { return tag_; }
+
+  /**
+   * @return true if alternative `I` is contained.
+   */
+  template <std::size_t I> bool is() const { return tag_ == I; }
+
+  /**
+   * @return true if the alternative of type `T` is contained.
+   */
+  template <typename T> bool is() const { return tag_ == indexOf<T>(); }
+
+  /**
+   * Returns alternative `I`.
+   *
+   * Undefined behavior if this does not contain alternative `I`.
+   */
+  template <std::size_t I> type_at<I>& get() {
+    assert(tag_ == I);
+    return *reinterpret_cast<type_at<I>*>(&storage_);
+  }
+
+  template <std::size_t I> const type_at<I>& get() const {
+    assert(tag_ == I);
+    return *reinterpret_cast<const type_at<I>*>(&storage_);
+  }
+
+  /**
+   * Returns the alternative of type `T`.
+   *
+   * Undefined behavior if this does not contain a `T`.
+   */
+  template <typename T> T& get() { return get<indexOf<T>()>(); }
+
+  template <typename T> const T& get() const { return get<indexOf<T>()>(); }
+
+  /**
+   * Calls `f` with the contained alternative.
+   *
+   * @param f Function object callable with every alternative, with the same
+   * return type.
+   */
+  template <typename F>
+  auto match(F f) const -> decltype(f(std::declval<const type_at<0>&>())) {
+    using R = decltype(f(std::declval<const type_at<0>&>()));
+    auto visitor = [&f](auto, const auto& t) -> R { return f(t); };
+    return detail::visit<R, Ts...>(tag_, visitor, storage_, indices());
+  }
+
+  template <typename F>
+  auto match(F f) -> decltype(f(std::declval<type_at<0>&>())) {
+    using R = decltype(f(std::declval<type_at<0>&>()));
+    auto visitor = [&f](auto, auto& t) -> R { return f(t); };
+    return detail::visit<R, Ts...>(tag_, visitor, storage_, indices());
+  }
+
+  /**
+   * Reduces to a single value, with one function object per alternative.
+   *
+   * @param fs Function objects, the `I`-th one called with alternative `I`.
+   * All have the same return type.
+   */
+  template <typename... Fs>
+  auto fold(Fs... fs) const
+      -> std::result_of_t<std::tuple_element_t<0, std::tuple<Fs...>>(
+          const type_at<0>&)> {
+    static_assert(sizeof...(Fs) == sizeof...(Ts),
+                  "OneOf::fold: one function object per alternative.");
+    using R = std::result_of_t<std::tuple_element_t<0, std::tuple<Fs...>>(
+        const type_at<0>&)>;
+    std::tuple<Fs&...> functions(fs...);
+    auto visitor = [&functions](auto i, const auto& t) -> R {
+      return std::get<decltype(i)::value>(functions)(t);
+    };
+    return detail::visit<R, Ts...>(tag_, visitor, storage_, indices());
+  }
+
+  /**
+   * Applies `f` to alternative `I` if it is contained.
+   *
+   * @param f Function object called with alternative `I`, with non-void
+   * return type `C`.
+   * @return OneOf with alternative `I` replaced by `C`, holding the result of
+   * `f` or a copy of the other alternative.
+   */
+  template <std::size_t I, typename F> auto mapAt(F f) const& {
+    using C = std::result_of_t<F(const type_at<I>&)>;
+    using Result = typename detail::ReplaceAt<I, C, indices, Ts...>::type;
+    auto visitor = [&f](auto i, const auto& t) -> Result {
+      return mapOne<Result, decltype(i)::value == I, decltype(i)::value>(f, t);
+    };
+    return detail::visit<Result, Ts...>(tag_, visitor, storage_, indices());
+  }
+
+  /**
+   * Applies `f` to alternative `I` if it is contained, moving the contained
+   * value.
+   */
+  template <std::size_t I, typename F> auto mapAt(F f) && {
+    using C = std::result_of_t<F(type_at<I>)>;
+    using Result = typename detail::ReplaceAt<I, C, indices, Ts...>::type;
+    auto visitor = [&f](auto i, auto& t) -> Result {
+      return mapOne<Result, decltype(i)::value == I, decltype(i)::value>(
+          f, std::move(t));
+    };
+    return detail::visit<Result, Ts...>(tag_, visitor, storage_, indices());
+  }
+
+  /**
+   * Applies `f` to the alternative of type `T` if it is contained.
+   */
+  template <typename T, typename F> auto map(F f) const& {
+    return mapAt<indexOf<T>()>(std::move(f));
+  }
+
+  template <typename T, typename F> auto map(F f) && {
+    return std::move(*this).template mapAt<indexOf<T>()>(std::move(f));
+  }
+
+  /**
+   * @return Nested Either `Either<T0, Either<T1, ... Either<Tn-1, Tn>>>`
+   * holding the contained alternative.
+   */
+  template <std::size_t N = sizeof...(Ts)>
+  auto toEither() const -> std::enable_if_t<
+      (N > 1), typename detail::NestedEither<Ts...>::type> {
+    using R = typename detail::NestedEither<Ts...>::type;
+    auto visitor = [](auto i, const auto& t) -> R {
+      return detail::Nest<decltype(i)::value, Ts...>::make(t);
+    };
+    return detail::visit<R, Ts...>(tag_, visitor, storage_, indices());
+  }
+
+  /**
+   * @return OneOf holding the innermost value of the nested Either `e`.
+   */
+  template <std::size_t N = sizeof...(Ts)>
+  static auto fromEither(const typename detail::NestedEither<Ts...>::type& e)
+      -> std::enable_if_t<(N > 1), OneOf> {
+    return unnest<0>(e, std::integral_constant<bool, N == 2>());
+  }
+
+ private:
+  template <typename Result, bool Mapped, std::size_t J, typename F,
+            typename T>
+  static std::enable_if_t<Mapped, Result> mapOne(F& f, T&& t) {
+    return Result(Alternative<J>(), f(std::forward<T>(t)));
+  }
+
+  template <typename Result, bool Mapped, std::size_t J, typename F,
+            typename T>
+  static std::enable_if_t<!Mapped, Result> mapOne(F&, T&& t) {
+    return Result(Alternative<J>(), std::forward<T>(t));
+  }
+
+  /* innermost Either, holding alternatives I and I + 1 */
+  template <std::size_t I, typename A, typename B>
+  static OneOf unnest(const Either<A, B>& e, std::true_type /* last */) {
+    if (e.isLeft()) {
+      return OneOf(Alternative<I>(), e.asLeft());
+    }
+    return OneOf(Alternative<I + 1>(), e.asRight());
+  }
+
+  template <std::size_t I, typename A, typename B>
+  static OneOf unnest(const Either<A, B>& e, std::false_type /* last */) {
+    if (e.isLeft()) {
+      return OneOf(Alternative<I>(), e.asLeft());
+    }
+    return unnest<I + 1>(e.asRight(),
+                         std::integral_constant<bool, I + 3 == size>());
+  }
+
+  void copyFrom(const OneOf& rhs) {
+    auto visitor = [this](auto, const auto& t) {
+      new (&storage_) std::decay_t<decltype(t)>(t);
+    };
+    detail::visit<void, Ts...>(tag_, visitor, rhs.storage_, indices());
+  }
+
+  void moveFrom(OneOf& rhs) {
+    auto visitor = [this](auto, auto& t) {
+      new (&storage_) std::decay_t<decltype(t)>(std::move(t));
+    };
+    detail::visit<void, Ts...>(tag_, visitor, rhs.storage_, indices());
+  }
+
+  void destroy() {
+    auto visitor = [](auto, auto& t) {
+      using T = std::decay_t<decltype(t)>;
+      t.~T();
+    };
+    detail::visit<void, Ts...>(tag_, visitor, storage_, indices());
+  }
+
+  template <typename... Us>
+  friend bool operator==(const OneOf<Us...>& lhs, const OneOf<Us...>& rhs);
+
+  using storage_t = typename std::aligned_union<1, Ts...>::type;
+  storage_t storage_;
+  tag_t tag_;
+};
+
+template <typename... Ts> constexpr std::size_t OneOf<Ts...>::size;
+
+template <typename... Ts>
+bool operator==(const OneOf<Ts...>& lhs, const OneOf<Ts...>& rhs) {
+  if (lhs.index() != rhs.index()) {
+    return false;
+  }
+  auto visitor = [&rhs](auto i, const auto& l) {
+    return l == rhs.template get<decltype(i)::value>();
+  };
+  return detail::visit<bool, Ts...>(lhs.index(), visitor, lhs.storage_,
+                                    std::index_sequence_for<Ts...>());
+}
+
+template <typename... Ts>
+bool operator!=(const OneOf<Ts...>& lhs, const OneOf<Ts...>& rhs) {
+  return !(lhs == rhs);
+}
+// @}
+}  // namespace ma
@@ -0,0 +1,382 @@
+#pragma once
+
+#include "either.hpp"
+#include "executor.hpp"
+#include "maybe.hpp"
+#include "reader.hpp"
+#include "utils.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <initializer_list>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace ma {
+/**
+ * @defgroup Parallel Parallel
+ * @addtogroup Parallel
+ * @{
+ * Structured parallel evaluation: functions are run in parallel, and the
+ * caller waits for all of them before continuing.
+ *
+ * Example
+ * -------
+ * ~~~
+ * Either<Err, std::tuple<User, Orders>> page = parZip(
+ *     [&]() { return loadUser(id); },
+ *     [&](const CancellationToken& cancel) { return loadOrders(id, cancel); });
+ *
+ * Reader<Services, std::tuple<User, Orders>> handler =
+ *     parReader(findUser(id), listOrders(id));
+ * ~~~
+ */
+
+/**
+ * Configuration of parReader.
+ */
+struct ParReaderOptions {
+  /** Pool running the readers, the shared WorkStealingPool if null. */
+  WorkStealingPool* pool = nullptr;
+  /** Readers are run inline while they are estimated to take less. */
+  std::chrono::nanoseconds inlineBelow = std::chrono::microseconds(50);
+};
+
+/**
+ * Tells long running functions that their result is no longer needed.
+ */
+class CancellationToken {
+ public:
+  explicit CancellationToken(const std::atomic<bool>& cancelled)
+      : cancelled_(&cancelled) {}
+
+  /**
+   * @return true iff the function should give up as soon as possible.
+   */
+  bool isCancelled() const {
+    return cancelled_->load(std::memory_order_relaxed);
+  }
+
+ private:
+  const std::atomic<bool>* cancelled_;
+};
+
+namespace detail {
+template <typename F>
+auto callCancellable(F& f, const CancellationToken& token, int)
+    -> decltype(f(token)) {
+  return f(token);
+}
+
+template <typename F>
+auto callCancellable(F& f, const CancellationToken&, long) -> decltype(f()) {
+  return f();
+}
+
+template <typename F>
+using CancellableResult = decltype(callCancellable(
+    std::declval<F&>(), std::declval<const CancellationToken&>(), 0));
+
+/**
+ * Counts down completed functions; waiting threads help running queued
+ * functions.
+ */
+class ParLatch {
+ public:
+  explicit ParLatch(std::size_t n) : remaining_(n) {}
+
+  void countDown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--remaining_ == 0) {
+      done_.notify_all();
+    }
+  }
+
+  template <typename Pool> void wait(Pool& pool) {
+    while (!isDone()) {
+      if (!pool.tryRunOne()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this]() { return remaining_ == 0; });
+      }
+    }
+  }
+
+ private:
+  bool isDone() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return remaining_ == 0;
+  }
+
+  std::mutex mutex_;
+  std::condition_variable done_;
+  std::size_t remaining_;
+};
+
+/**
+ * Result of a function run in parallel, references are stored as pointers.
+ */
+template <typename T> class ParSlot {
+ public:
+  template <typename U> void emplace(U&& u) {
+    value_.emplace(std::forward<U>(u));
+  }
+  T get() { return std::move(value_.get()); }
+
+ private:
+  Maybe<T> value_;
+};
+
+template <typename T> class ParSlot<T&> {
+ public:
+  void emplace(T& t) { value_ = &t; }
+  T& get() { return *value_; }
+
+ private:
+  T* value_ = nullptr;
+};
+
+/**
+ * State of a parZip, on the stack of its caller.
+ */
+template <typename E, typename... Ts> class ParJoin {
+ public:
+  explicit ParJoin(std::size_t n) : latch_(n) {}
+
+  template <std::size_t I, typename F> void run(F& f) {
+    if (!cancelled_.load(std::memory_order_acquire)) {
+      try {
+        auto r = callCancellable(f, CancellationToken(cancelled_), 0);
+        if (r.isRight()) {
+          std::get<I>(slots_).emplace(std::move(r.asRight()));
+        } else if (!failed_.exchange(true, std::memory_order_acq_rel)) {
+          error_.emplace(std::move(r.asLeft()));
+        }
+      } catch (...) {
+        if (!failed_.exchange(true, std::memory_order_acq_rel)) {
+          exception_ = std::current_exception();
+        }
+      }
+      if (failed_.load(std::memory_order_acquire)) {
+        cancelled_.store(true, std::memory_order_release);
+      }
+    }
+    latch_.countDown();
+  }
+
+  template <typename Pool> void wait(Pool& pool) { latch_.wait(pool); }
+
+  template <std::size_t... Is>
+  Either<E, std::tuple<Ts...>> result(std::index_sequence<Is...>) {
+    if (exception_) {
+      std::rethrow_exception(exception_);
+    }
+    if (error_.isJust()) {
+      return Either<E, std::tuple<Ts...>>(Left, std::move(error_.get()));
+    }
+    return Either<E, std::tuple<Ts...>>(Right, std::get<Is>(slots_).get()...);
+  }
+
+ private:
+  std::tuple<ParSlot<Ts>...> slots_;
+  Maybe<E> error_;
+  std::exception_ptr exception_;
+  std::atomic<bool> failed_{false};
+  std::atomic<bool> cancelled_{false};
+  ParLatch latch_;
+};
+
+template <typename E, typename R> struct IsEitherOf : std::false_type {};
+template <typename E, typename T>
+struct IsEitherOf<E, Either<E, T>> : std::true_type {};
+
+template <typename Pool, typename... Fs, std::size_t I0, std::size_t... Is>
+auto parZip(Pool& pool, std::index_sequence<I0, Is...>, Fs&... fs) {
+  using E = typename CancellableResult<
+      std::tuple_element_t<0, std::tuple<Fs...>>>::left_type;
+  static_assert(AllOf<IsEitherOf<E, CancellableResult<Fs>>::value...>::value,
+                "parZip: all functions must return Either<E, T> for the "
+                "same E.");
+
+  ParJoin<E, typename CancellableResult<Fs>::right_type...> join(
+      sizeof...(Fs));
+  std::tuple<Fs&...> functions(fs...);
+  /* captures two references only, which std::function stores in place */
+  (void)std::initializer_list<int>{
+      (pool.execute([&join, &functions]() {
+         join.template run<Is>(std::get<Is>(functions));
+       }),
+       0)...};
+  join.template run<I0>(std::get<I0>(functions));
+  join.wait(pool);
+  return join.result(std::index_sequence<I0, Is...>());
+}
+}  // namespace detail
+
+/**
+ * Runs independent functions in parallel and combines their results.
+ *
+ * Each function is called either without arguments or with a
+ * `const CancellationToken&`, and returns `Either<E, T_i>` for the same `E`.
+ * The first function runs on the calling thread, the others are submitted to
+ * `pool`; while waiting, the caller runs queued functions itself, so nested
+ * calls do not starve the pool.
+ *
+ * The first left value cancels the remaining functions: those not started
+ * yet are skipped, those running observe `CancellationToken::isCancelled`.
+ *
+ * Results are written into slots on the stack of the caller, joining does not
+ * allocate.
+ *
+ * An exception thrown by a function cancels the others like a left value;
+ * once all functions finished, it is rethrown.
+ *
+ * @return Tuple of the right values of all functions, or the first left value
+ * encountered.
+ */
+template <typename... Fs>
+auto parZip(WorkStealingPool& pool, Fs&&... fs) {
+  return detail::parZip(pool, std::index_sequence_for<Fs...>(), fs...);
+}
+
+/**
+ * parZip on the shared WorkStealingPool.
+ */
+template <typename... Fs> auto parZip(Fs&&... fs) {
+  return parZip(WorkStealingPool::shared(), std::forward<Fs>(fs)...);
+}
+
+namespace detail {
+/**
+ * Runs readers, in parallel unless they are estimated to be cheap.
+ */
+template <typename A, typename... Rs> class ParReader {
+ public:
+  using result_type = std::tuple<Rs...>;
+
+  ParReader(const ParReaderOptions& options, Reader<A, Rs>... readers)
+      : pool_(options.pool ? *options.pool : WorkStealingPool::shared()),
+        inlineBelow_(options.inlineBelow.count()),
+        readers_(std::move(readers)...),
+        cost_(std::make_shared<std::atomic<std::int64_t>>(0)) {}
+
+  result_type operator()(const A& a) const {
+    if (cost_->load(std::memory_order_relaxed) < inlineBelow_) {
+      return runInline(a, std::index_sequence_for<Rs...>());
+    }
+    return runParallel(a, std::index_sequence_for<Rs...>());
+  }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  static std::int64_t elapsed(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                                start)
+        .count();
+  }
+
+  /* exponential moving average of the total run time */
+  void record(std::int64_t cost) const {
+    const std::int64_t old = cost_->load(std::memory_order_relaxed);
+    cost_->store((3 * old + cost) / 4, std::memory_order_relaxed);
+  }
+
+  template <std::size_t... Is>
+  result_type runInline(const A& a, std::index_sequence<Is...>) const {
+    const auto start = Clock::now();
+    /* braced initialization runs the readers in order */
+    result_type result{std::get<Is>(readers_).run(a)...};
+    record(elapsed(start));
+    return result;
+  }
+
+  template <std::size_t I0, std::size_t... Is>
+  result_type runParallel(const A& a,
+                          std::index_sequence<I0, Is...>) const {
+    Join join(*this, a);
+    /* captures a single reference, which std::function stores in place */
+    (void)std::initializer_list<int>{
+        (pool_.execute([&join]() { join.self.template run<Is>(join); }),
+         0)...};
+    run<I0>(join);
+    join.latch.wait(pool_);
+    record(join.cost.load(std::memory_order_relaxed));
+    if (join.error) {
+      std::rethrow_exception(join.error);
+    }
+    return result_type(std::get<I0>(join.slots).get(),
+                       std::get<Is>(join.slots).get()...);
+  }
+
+  struct Join {
+    Join(const ParReader& self_, const A& env_)
+        : self(self_), env(env_), latch(sizeof...(Rs)) {}
+
+    const ParReader& self;
+    const A& env;
+    std::tuple<ParSlot<Rs>...> slots;
+    std::atomic<std::int64_t> cost{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    ParLatch latch;
+  };
+
+  template <std::size_t I> void run(Join& join) const {
+    const auto start = Clock::now();
+    try {
+      std::get<I>(join.slots).emplace(std::get<I>(readers_).run(join.env));
+    } catch (...) {
+      if (!join.failed.exchange(true, std::memory_order_acq_rel)) {
+        join.error = std::current_exception();
+      }
+    }
+    join.cost.fetch_add(elapsed(start), std::memory_order_relaxed);
+    join.latch.countDown();
+  }
+
+  WorkStealingPool& pool_;
+  const std::int64_t inlineBelow_;
+  const std::tuple<Reader<A, Rs>...> readers_;
+  /* shared by all copies, estimated in nanoseconds */
+  std::shared_ptr<std::atomic<std::int64_t>> cost_;
+};
+}  // namespace detail
+
+/**
+ * Combines readers depending on the same environment into one, which runs
+ * them concurrently.
+ *
+ * The readers run in parallel on `options.pool` and must only read the
+ * environment. Running them costs some synchronization, so the combined
+ * reader measures how long they take, and runs them inline on the calling
+ * thread while that is less than `options.inlineBelow`. The first run is
+ * always inline.
+ *
+ * If readers throw, the first exception is rethrown once all readers
+ * finished.
+ *
+ * @return Reader of the tuple of the results of all `readers`.
+ */
+template <typename A, typename... Rs>
+Reader<A, std::tuple<Rs...>> parReader(const ParReaderOptions& options,
+                                       Reader<A, Rs>... readers) {
+  static_assert(sizeof...(Rs) > 0, "parReader: no readers given.");
+  return Reader<A, std::tuple<Rs...>>(
+      detail::ParReader<A, Rs...>(options, std::move(readers)...));
+}
+
+/**
+ * parReader with default options.
+ */
+template <typename A, typename... Rs>
+Reader<A, std::tuple<Rs...>> parReader(Reader<A, Rs>... readers) {
+  return parReader(ParReaderOptions(), std::move(readers)...);
+}
+// @}
+}  // namespace ma
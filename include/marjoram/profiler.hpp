@@ -0,0 +1,438 @@
+#pragma once
+
+#ifdef MARJORAM_PROFILE_LAZY
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#endif
+
+namespace ma {
+/**
+ * @defgroup Profiler Profiler
+ * @addtogroup Profiler
+ * @{
+ * Opt-in profiling of Lazy evaluation.
+ *
+ * Profiling is enabled by defining `MARJORAM_PROFILE_LAZY` before including
+ * any marjoram header (it must be defined consistently for the whole program,
+ * as it changes the layout of `Lazy`). Without it, labels are discarded at
+ * compile time and `Lazy` carries no additional state.
+ *
+ * When enabled, every evaluation of a `Lazy` records its label, source
+ * location, duration and evaluating thread into a buffer owned by that
+ * thread. Evaluations triggered while another evaluation is running on the
+ * same thread (e.g. through `map`, `flatMap` or `Flatten`) are recorded as its
+ * children.
+ *
+ * Recording takes no lock. When a thread exits, its buffer is kept for export
+ * and handed to the next thread that starts recording, which reports the
+ * same thread id; `reset` releases the buffers of exited threads.
+ *
+ * Example
+ * -------
+ * ~~~
+ * Lazy<Index> index(buildIndex);
+ * index.labeled(MARJORAM_LAZY_LABEL("buildIndex"));
+ * auto hits = index.map(query).labeled(MARJORAM_LAZY_LABEL("query"));
+ * hits.get();
+ *
+ * std::ofstream trace("lazy.json");
+ * ma::profiler::writeChromeTrace(trace);
+ * ~~~
+ */
+
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_FILE) && __has_builtin(__builtin_LINE)
+#define MARJORAM_HAS_BUILTIN_LOCATION 1
+#endif
+#endif
+
+/**
+ * Name and source location of a Lazy node, as reported by the profiler.
+ */
+struct LazyLabel {
+  const char* name;
+  const char* file;
+  int line;
+
+  /**
+   * Creates a LazyLabel named `name`. Used as a default argument, it refers
+   * to the location of the caller if the compiler provides it
+   * (`MARJORAM_HAS_BUILTIN_LOCATION` is then defined), and to no location
+   * otherwise.
+   */
+#ifdef MARJORAM_HAS_BUILTIN_LOCATION
+  static LazyLabel caller(const char* name, const char* file = __builtin_FILE(),
+                          int line = __builtin_LINE()) {
+    return LazyLabel{name, file, line};
+  }
+#else
+  static LazyLabel caller(const char* name) {
+    return LazyLabel{name, nullptr, 0};
+  }
+#endif
+};
+
+/**
+ * Creates a LazyLabel named `name` referring to the current source location.
+ */
+#define MARJORAM_LAZY_LABEL(name) (::ma::LazyLabel{(name), __FILE__, __LINE__})
+
+#ifdef MARJORAM_PROFILE_LAZY
+namespace profiler {
+using Clock = std::chrono::steady_clock;
+
+/**
+ * A single evaluation of a Lazy node.
+ */
+struct Event {
+  LazyLabel label;
+  /** Start of evaluation in nanoseconds since the profiler epoch. */
+  std::uint64_t start;
+  /** Duration of evaluation in nanoseconds. */
+  std::uint64_t duration;
+  /** Index of the enclosing evaluation in the same buffer, if any. */
+  std::size_t parent;
+};
+
+/** Value of `Event::parent` for evaluations without enclosing evaluation. */
+static const std::size_t NoParent = static_cast<std::size_t>(-1);
+
+/**
+ * Events recorded by a single thread at a time.
+ *
+ * The recording thread appends without locking and publishes events through
+ * an atomic count; their storage does not move while the buffer is in use.
+ * Other threads only read it while holding the registry mutex.
+ */
+class ThreadBuffer {
+ public:
+  explicit ThreadBuffer(unsigned tid) : tid_(tid) {}
+
+  ThreadBuffer(const ThreadBuffer&) = delete;
+  ThreadBuffer& operator=(const ThreadBuffer&) = delete;
+
+  unsigned tid() const { return tid_; }
+
+  /* recording thread: starts an evaluation nested in the innermost open one */
+  void open(const LazyLabel& label, std::uint64_t start) {
+    const std::size_t index = size_.load(std::memory_order_relaxed);
+    const std::size_t parent = open_.empty() ? NoParent : open_.back();
+    Slot& slot = append(index);
+    slot.event = Event{label, start, 0, parent};
+    slot.duration.store(0, std::memory_order_relaxed);
+    size_.store(index + 1, std::memory_order_release);
+    open_.push_back(index);
+    openSlots_.push_back(&slot);
+  }
+
+  /* recording thread: ends the innermost open evaluation */
+  void close(std::uint64_t end) {
+    Slot& slot = *openSlots_.back();
+    open_.pop_back();
+    openSlots_.pop_back();
+    slot.duration.store(end - slot.event.start, std::memory_order_relaxed);
+  }
+
+  /* recording thread: whether events discarded by reset can be released */
+  bool collectable() const {
+    return open_.empty() && discarded_.load(std::memory_order_relaxed) != 0;
+  }
+
+  /* recording thread, holding the registry mutex: keeps the events recorded
+   * since the last reset only */
+  void collect() {
+    const std::vector<Event> kept = snapshot();
+    if (head_) {
+      head_->next.reset();
+    }
+    tail_ = head_.get();
+    for (std::size_t i = 0; i < kept.size(); ++i) {
+      Slot& slot = append(i);
+      slot.event = kept[i];
+      slot.duration.store(kept[i].duration, std::memory_order_relaxed);
+    }
+    size_.store(kept.size(), std::memory_order_relaxed);
+    discarded_.store(0, std::memory_order_relaxed);
+  }
+
+  /* holding the registry mutex: hides the events recorded so far, which
+   * the recording thread releases once it has no evaluation open */
+  void discard() {
+    discarded_.store(size_.load(std::memory_order_acquire),
+                     std::memory_order_relaxed);
+  }
+
+  /* holding the registry mutex: events recorded since the last reset, with
+   * parents recorded before it replaced by NoParent */
+  std::vector<Event> snapshot() const {
+    const std::size_t size = size_.load(std::memory_order_acquire);
+    const std::size_t first = discarded_.load(std::memory_order_relaxed);
+    std::vector<Event> events;
+    events.reserve(size - first);
+    const Chunk* chunk = head_.get();
+    for (std::size_t i = 0; i < size; ++i) {
+      if (i > 0 && i % Chunk::capacity == 0) {
+        chunk = chunk->next.get();
+      }
+      if (i < first) {
+        continue;
+      }
+      const Slot& slot = chunk->slots[i % Chunk::capacity];
+      Event e = slot.event;
+      e.duration = slot.duration.load(std::memory_order_relaxed);
+      e.parent = e.parent == NoParent || e.parent < first ? NoParent
+                                                          : e.parent - first;
+      events.push_back(e);
+    }
+    return events;
+  }
+
+ private:
+  struct Slot {
+    Event event;
+    /* written when the evaluation ends, possibly while being exported */
+    std::atomic<std::uint64_t> duration{0};
+  };
+
+  struct Chunk {
+    static const std::size_t capacity = 256;
+
+    Slot slots[capacity];
+    std::unique_ptr<Chunk> next;
+  };
+
+  Slot& append(std::size_t index) {
+    if (!head_) {
+      head_.reset(new Chunk());
+      tail_ = head_.get();
+    } else if (index > 0 && index % Chunk::capacity == 0) {
+      if (!tail_->next) {
+        tail_->next.reset(new Chunk());
+      }
+      tail_ = tail_->next.get();
+    }
+    return tail_->slots[index % Chunk::capacity];
+  }
+
+  const unsigned tid_;
+  std::unique_ptr<Chunk> head_;
+  Chunk* tail_ = nullptr;
+  std::atomic<std::size_t> size_{0};
+  /* number of leading events discarded by reset */
+  std::atomic<std::size_t> discarded_{0};
+  /* indices and slots of evaluations in progress */
+  std::vector<std::size_t> open_;
+  std::vector<Slot*> openSlots_;
+};
+
+namespace detail {
+struct Registry {
+  Registry() : epoch(Clock::now()) {}
+
+  /* reuses the buffer of a thread that exited, if any */
+  std::shared_ptr<ThreadBuffer> acquire() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!idle.empty()) {
+      std::shared_ptr<ThreadBuffer> buffer = std::move(idle.back());
+      idle.pop_back();
+      return buffer;
+    }
+    buffers.push_back(std::make_shared<ThreadBuffer>(++threads));
+    return buffers.back();
+  }
+
+  void release(std::shared_ptr<ThreadBuffer> buffer) {
+    std::lock_guard<std::mutex> lock(mutex);
+    idle.push_back(std::move(buffer));
+  }
+
+  std::uint64_t now() const {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                             epoch)
+            .count());
+  }
+
+  const Clock::time_point epoch;
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+  /* buffers of threads that exited, kept for export until reset */
+  std::vector<std::shared_ptr<ThreadBuffer>> idle;
+  unsigned threads = 0;
+};
+
+inline Registry& registry() {
+  static Registry r;
+  return r;
+}
+
+/* hands the buffer of the calling thread back to the registry on exit */
+struct BufferOwner {
+  BufferOwner() : buffer(registry().acquire()) {}
+  ~BufferOwner() { registry().release(std::move(buffer)); }
+
+  std::shared_ptr<ThreadBuffer> buffer;
+};
+
+inline ThreadBuffer& localBuffer() {
+  thread_local BufferOwner owner;
+  return *owner.buffer;
+}
+
+inline const char* nameOf(const Event& e) {
+  return e.label.name ? e.label.name : "Lazy";
+}
+
+inline void writeJsonString(std::ostream& os, const char* s) {
+  os << '"';
+  for (; *s; ++s) {
+    switch (*s) {
+      case '"':
+        os << "\\\"";
+        break;
+      case '\\':
+        os << "\\\\";
+        break;
+      case '\n':
+        os << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(*s) < 0x20) {
+          os << ' ';
+        } else {
+          os << *s;
+        }
+    }
+  }
+  os << '"';
+}
+
+/* calls f(tid, events) for a snapshot of every thread buffer */
+template <typename F> void forEachBuffer(F f) {
+  std::vector<std::pair<unsigned, std::vector<Event>>> snapshots;
+  {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    for (const auto& buffer : registry().buffers) {
+      snapshots.emplace_back(buffer->tid(), buffer->snapshot());
+    }
+  }
+  for (const auto& snapshot : snapshots) {
+    f(snapshot.first, snapshot.second);
+  }
+}
+}  // namespace detail
+
+/**
+ * Records the evaluation of a Lazy node for the lifetime of this object.
+ */
+class Scope {
+ public:
+  explicit Scope(const LazyLabel& label) : buffer_(detail::localBuffer()) {
+    if (buffer_.collectable()) {
+      std::lock_guard<std::mutex> lock(detail::registry().mutex);
+      buffer_.collect();
+    }
+    buffer_.open(label, detail::registry().now());
+  }
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+  ~Scope() { buffer_.close(detail::registry().now()); }
+
+ private:
+  ThreadBuffer& buffer_;
+};
+
+/**
+ * Discards all recorded events. Evaluations in progress while resetting are
+ * not recorded. Buffers of threads that exited are released.
+ */
+inline void reset() {
+  detail::Registry& r = detail::registry();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  for (const auto& buffer : r.idle) {
+    r.buffers.erase(std::find(r.buffers.begin(), r.buffers.end(), buffer));
+  }
+  r.idle.clear();
+  for (const auto& buffer : r.buffers) {
+    buffer->discard();
+  }
+}
+
+/**
+ * Writes all recorded events in the Chrome trace event format (viewable in
+ * `chrome://tracing` or Perfetto). Each evaluation is a complete ("X") event;
+ * the label of the enclosing evaluation is stored in `args.parent`.
+ */
+inline void writeChromeTrace(std::ostream& os) {
+  os << "{\"traceEvents\":[";
+  bool first = true;
+  detail::forEachBuffer([&](unsigned tid, const std::vector<Event>& events) {
+    for (const Event& e : events) {
+      os << (first ? "\n" : ",\n") << "{\"name\":";
+      first = false;
+      detail::writeJsonString(os, detail::nameOf(e));
+      os << ",\"cat\":\"lazy\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+         << ",\"ts\":" << e.start / 1000 << '.' << e.start % 1000 / 100
+         << ",\"dur\":" << e.duration / 1000 << '.' << e.duration % 1000 / 100
+         << ",\"args\":{";
+      if (e.label.file) {
+        os << "\"file\":";
+        detail::writeJsonString(os, e.label.file);
+        os << ",\"line\":" << e.label.line << ',';
+      }
+      os << "\"parent\":";
+      detail::writeJsonString(
+          os, e.parent == NoParent ? "" : detail::nameOf(events[e.parent]));
+      os << "}}";
+    }
+  });
+  os << "\n]}\n";
+}
+
+/**
+ * Writes all recorded events in the collapsed stack format understood by
+ * `flamegraph.pl` and speedscope: one line per distinct stack of labels,
+ * followed by the self time spent in it in microseconds.
+ */
+inline void writeCollapsedStacks(std::ostream& os) {
+  std::map<std::string, std::uint64_t> stacks;
+  detail::forEachBuffer([&](unsigned, const std::vector<Event>& events) {
+    /* self time: own duration minus that of direct children */
+    std::vector<std::int64_t> self(events.size());
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      self[i] += static_cast<std::int64_t>(events[i].duration);
+      if (events[i].parent != NoParent) {
+        self[events[i].parent] -= static_cast<std::int64_t>(events[i].duration);
+      }
+    }
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      std::string stack = detail::nameOf(events[i]);
+      for (std::size_t p = events[i].parent; p != NoParent;
+           p = events[p].parent) {
+        stack = detail::nameOf(events[p]) + (';' + stack);
+      }
+      /* evaluations still in progress have no duration yet */
+      stacks[stack] +=
+          static_cast<std::uint64_t>(std::max<std::int64_t>(self[i], 0));
+    }
+  });
+  for (const auto& stack : stacks) {
+    os << stack.first << ' ' << stack.second / 1000 << '\n';
+  }
+}
+}  // namespace profiler
+#endif
+// @}
+}  // namespace ma
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 
 namespace ma {
 /**
@@ -19,20 +20,36 @@ namespace ma {
  * for illustration).
  */
 
+namespace detail {
+/* object referred to by environments passed by reference or pointer */
+template <typename T> const T& referent(const T& t) { return t; }
+template <typename T> const T& referent(const std::reference_wrapper<T>& t) {
+  return t.get();
+}
+template <typename T> const T& referent(T* const& t) { return *t; }
+template <typename T> const T& referent(const std::shared_ptr<T>& t) {
+  return *t;
+}
+}  // namespace detail
+
 /**
  * Reader Monad
  *
  * Essentially std::function with sugar on top.
  *
  * Represents computations that require a shared resource `A` to run.
- * map/flatMap composes further computations.
+ * map/flatMap composes further computations, local runs them with a part of a
+ * larger resource.
  */
 template <class A, class R> class Reader {
  public:
-  Reader(std::function<R(A)> f) : f_(f) {}
+  Reader(std::function<R(const A&)> f) : f_(f) {}
 
   /**
    * Run the function.
+   *
+   * The environment is passed on by reference, composed readers do not copy
+   * it.
    */
   R run(const A& a) const { return f_(a); }
 
@@ -69,8 +86,32 @@ template <class A, class R> class Reader {
         [f, self = *this](const A& a) { return f(self.run(a)).run(a); });
   }
 
+  /**
+   * Runs this reader within a larger environment, also known as contramap.
+   *
+   * Example
+   * -------
+   * ~~~
+   * Reader<Services, User> user = getUser(id).local<Services>(
+   *     [](const Services& s) -> const UserRepository& { return s.users; });
+   * ~~~
+   *
+   * @param p Function object.
+   *
+   * Type requirement:
+   * - `P::operator()` when called with `const B&` argument returns `const A&`,
+   *   typically a member of `B`, or a value convertible to `A`, such as a
+   *   lightweight view.
+   *
+   * @return `Reader<B, R>`.
+   */
+  template <typename B, typename P> Reader<B, R> local(P p) const {
+    return Reader<B, R>(
+        [p, self = *this](const B& b) -> R { return self.run(p(b)); });
+  }
+
  private:
-  const std::function<R(A)> f_;
+  const std::function<R(const A&)> f_;
 };
 // @}
 }  // namespace ma
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "maybe.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace ma {
+/**
+ * @addtogroup Lazy
+ * @{
+ */
+
+template <typename A> class SharedLazy;
+class Speculator;
+
+/**
+ * Thread safe lazy `A`, whose copies share the same state.
+ *
+ * The function is evaluated at most once (unless it throws, in which case the
+ * next call to `get` tries again), regardless of how many threads call `get`
+ * concurrently. Threads calling `get` while another thread is evaluating wait
+ * for its result.
+ *
+ * Evaluation may be started ahead of demand by a Speculator.
+ */
+template <typename A> class SharedLazy {
+ public:
+  using value_type = A;
+
+  static_assert(std::is_same<std::decay_t<A>, A>::value,
+                "SharedLazy<A>: A must be a value type.");
+
+  /**
+   * @param f Function that will be called once when `get` is called the first
+   * time, or when a Speculator decides to evaluate it.
+   */
+  explicit SharedLazy(std::function<A()> f)
+      : state_(std::make_shared<State>(std::move(f))) {}
+
+  /**
+   * @return true iff has been evaluated.
+   */
+  bool isEvaluated() const {
+    return state_->status.load(std::memory_order_acquire) == done;
+  }
+
+  /**
+   * @return If the function has not yet been evaluated, evaluates it (or
+   * waits for the thread that is evaluating it). Then returns the stored
+   * value.
+   */
+  const A& get() const {
+    State& s = *state_;
+    while (s.status.load(std::memory_order_acquire) != done) {
+      if (!tryEvaluate(s)) {
+        std::unique_lock<std::mutex> lock(s.mutex);
+        s.finished.wait(lock, [&s]() {
+          return s.status.load(std::memory_order_acquire) != running;
+        });
+      }
+    }
+    return s.value.get();
+  }
+
+ private:
+  friend class Speculator;
+
+  enum Status : int { pending, running, done };
+
+  struct State {
+    explicit State(std::function<A()> f_) : f(std::move(f_)) {}
+
+    std::atomic<int> status{pending};
+    std::function<A()> f;
+    Maybe<A> value;
+    /* only used to wait for another thread evaluating */
+    std::mutex mutex;
+    std::condition_variable finished;
+  };
+
+  /* evaluates unless another thread already claimed the evaluation */
+  static bool tryEvaluate(State& s) {
+    int expected = pending;
+    if (!s.status.compare_exchange_strong(expected, running,
+                                          std::memory_order_acq_rel)) {
+      return false;
+    }
+    try {
+      s.value.emplace(s.f());
+      s.f = nullptr;
+    } catch (...) {
+      finish(s, pending);
+      throw;
+    }
+    finish(s, done);
+    return true;
+  }
+
+  static void finish(State& s, int status) {
+    {
+      std::lock_guard<std::mutex> lock(s.mutex);
+      s.status.store(status, std::memory_order_release);
+    }
+    s.finished.notify_all();
+  }
+
+  std::shared_ptr<State> state_;
+};
+
+/**
+ * @return Load average of the last minute per hardware thread, or 0 if it
+ * cannot be determined on this platform.
+ */
+inline double systemLoad() {
+#if defined(__unix__) || defined(__APPLE__)
+  double load = 0;
+  if (getloadavg(&load, 1) != 1) {
+    return 0;
+  }
+  const unsigned cores = std::thread::hardware_concurrency();
+  return load / (cores ? cores : 1);
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Configuration of a Speculator.
+ */
+struct SpeculationOptions {
+  /** Number of worker threads. */
+  unsigned workers = 1;
+  /** Speculation pauses while `loadProbe()` is at or above this value. */
+  double maxLoad = 0.75;
+  /** Time to wait before probing the load again after pausing. */
+  std::chrono::milliseconds backoff{10};
+  /** Current load, by default `systemLoad`. */
+  std::function<double()> loadProbe = systemLoad;
+};
+
+/**
+ * Evaluates SharedLazy values ahead of demand on background threads.
+ *
+ * Registered values are evaluated in order of descending priority, cheaper
+ * ones first among equal priority. Speculation never competes with demand:
+ * values already being evaluated (or evaluated) by `get` are skipped, values
+ * no longer referenced by anyone are dropped, and workers pause while the
+ * load reported by `SpeculationOptions::loadProbe` is too high.
+ *
+ * Example
+ * -------
+ * ~~~
+ * Speculator speculator;
+ * SharedLazy<Report> report([]() { return buildReport(); });
+ * speculator.speculate(report, 10);
+ * // ... later, likely without waiting:
+ * report.get();
+ * ~~~
+ *
+ * Pending speculation is abandoned when the Speculator is destroyed.
+ */
+class Speculator {
+ public:
+  explicit Speculator(SpeculationOptions options = SpeculationOptions())
+      : options_(std::move(options)) {
+    for (unsigned i = 0; i < options_.workers; ++i) {
+      workers_.emplace_back([this]() { work(); });
+    }
+  }
+
+  Speculator(const Speculator&) = delete;
+  Speculator& operator=(const Speculator&) = delete;
+
+  ~Speculator() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wakeup_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /**
+   * Registers `la` for speculative evaluation.
+   *
+   * @param priority Values with higher priority are evaluated first.
+   * @param cost Estimated cost of evaluation, in arbitrary units.
+   */
+  template <typename A>
+  void speculate(const SharedLazy<A>& la, int priority = 0, double cost = 1) {
+    std::weak_ptr<typename SharedLazy<A>::State> state = la.state_;
+    auto run = [state]() {
+      if (auto s = state.lock()) {
+        try {
+          SharedLazy<A>::tryEvaluate(*s);
+        } catch (...) {
+          /* left to demand evaluation to report */
+        }
+      }
+    };
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push(Task{priority, cost, sequence_++, run});
+    }
+    wakeup_.notify_one();
+  }
+
+  /**
+   * @return Number of registered values not yet considered by a worker.
+   */
+  std::size_t pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+  }
+
+ private:
+  struct Task {
+    int priority;
+    double cost;
+    std::size_t sequence;
+    std::function<void()> run;
+
+    /* lower "less" means evaluated later */
+    bool operator<(const Task& other) const {
+      if (priority != other.priority) {
+        return priority < other.priority;
+      }
+      if (cost != other.cost) {
+        return cost > other.cost;
+      }
+      return sequence > other.sequence;
+    }
+  };
+
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+      if (queue_.empty()) {
+        wakeup_.wait(lock);
+        continue;
+      }
+      if (options_.loadProbe() >= options_.maxLoad) {
+        wakeup_.wait_for(lock, options_.backoff);
+        continue;
+      }
+      Task task = queue_.top();
+      queue_.pop();
+      lock.unlock();
+      task.run();
+      lock.lock();
+    }
+  }
+
+  const SpeculationOptions options_;
+  mutable std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::priority_queue<Task> queue_;
+  std::size_t sequence_ = 0;
+  bool stop_ = false;
+  std::vector<std::thread> workers_;
+};
+// @}
+}  // namespace ma
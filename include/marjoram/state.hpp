@@ -0,0 +1,183 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace ma {
+/**
+ * @defgroup State State
+ * @addtogroup State
+ * @{
+ * State Monad, computations threading a state of type `S`.
+ *
+ * ~~~
+ * template <class S, class F> class State;
+ * ~~~
+ *
+ * Each step receives the state as `S&`, the only reference to it while the
+ * computation runs, and may update it in place: running a chain of steps
+ * with a vector or a map never copies it. The state is moved in and out of
+ * `run`, so it is only copied when the caller passes an lvalue it keeps.
+ *
+ * Like Ask, States compose statically, without type erasure: `F` is the type
+ * of the function object, the value type is deduced from it.
+ *
+ * Example
+ * -------
+ * ~~~
+ * using Particles = std::vector<Particle>;
+ *
+ * auto advance = modify<Particles>([](Particles& ps) {
+ *   for (auto& p : ps) p.move();
+ * });
+ * auto energy = gets<Particles>([](const Particles& ps) { return sum(ps); });
+ *
+ * auto simulation = advance.repeat(1000).flatMap([=](Unit) { return energy; });
+ * std::pair<double, Particles> result = simulation.run(std::move(particles));
+ * ~~~
+ */
+
+/**
+ * Value of computations returning nothing.
+ */
+struct Unit {};
+
+inline bool operator==(Unit, Unit) { return true; }
+inline bool operator!=(Unit, Unit) { return false; }
+
+template <typename S, typename F> class State;
+
+namespace detail {
+template <typename S, typename F> State<S, F> makeState(F f) {
+  return State<S, F>(std::move(f));
+}
+}  // namespace detail
+
+/**
+ * State monad.
+ *
+ * Type requirement:
+ * - `F::operator()` when called with `S&` argument has a non-void return
+ *   type, the value of the computation.
+ */
+template <typename S, typename F> class State {
+  static_assert(std::is_same<std::decay_t<S>, S>::value,
+                "State<S, F>: S must be a value type.");
+
+ public:
+  using state_type = S;
+  using value_type = std::decay_t<std::result_of_t<const F&(S&)>>;
+
+  explicit State(F f) : f_(std::move(f)) {}
+
+  /**
+   * Runs the computation on `s`, updating it in place.
+   *
+   * @return The value of the computation, which may refer to `s`.
+   */
+  decltype(auto) apply(S& s) const { return f_(s); }
+
+  /**
+   * @return The value of the computation and the final state.
+   */
+  std::pair<value_type, S> run(S s) const {
+    value_type a = f_(s);
+    return std::pair<value_type, S>(std::move(a), std::move(s));
+  }
+
+  /**
+   * @return The value of the computation.
+   */
+  value_type eval(S s) const { return f_(s); }
+
+  /**
+   * @return The final state.
+   */
+  S exec(S s) const {
+    f_(s);
+    return s;
+  }
+
+  /**
+   * @param g Function object.
+   *
+   * Type requirement:
+   * - `G::operator()` when called with the value of this computation has
+   *   non-void return type `C`.
+   *
+   * @return State with value `C`.
+   */
+  template <typename G> auto map(G g) const {
+    auto f = f_;
+    return detail::makeState<S>(
+        [f, g](S& s) -> decltype(auto) { return g(f(s)); });
+  }
+
+  /**
+   * @param g Function object.
+   *
+   * Type requirement:
+   * - `G::operator()` when called with the value of this computation returns
+   *   a `State<S, H>`.
+   *
+   * @return State running this, then the result of `g`, on the same state.
+   */
+  template <typename G> auto flatMap(G g) const {
+    auto f = f_;
+    return detail::makeState<S>(
+        [f, g](S& s) -> decltype(auto) { return g(f(s)).apply(s); });
+  }
+
+  /**
+   * @return State running this `n` times, with value Unit.
+   */
+  auto repeat(std::size_t n) const {
+    auto f = f_;
+    return detail::makeState<S>([f, n](S& s) {
+      for (std::size_t i = 0; i < n; ++i) {
+        f(s);
+      }
+      return Unit();
+    });
+  }
+
+ private:
+  F f_;
+};
+
+/**
+ * @param f Function object, called with `S&`, with non-void return type.
+ *
+ * @return State of the step `f`.
+ */
+template <typename S, typename F> State<S, F> state(F f) {
+  return State<S, F>(std::move(f));
+}
+
+/**
+ * @return State with value `a`, leaving the state unchanged.
+ */
+template <typename S, typename A> auto pure(A a) {
+  return detail::makeState<S>([a](S&) { return a; });
+}
+
+/**
+ * @return State with value `f(s)`, leaving the state unchanged.
+ */
+template <typename S, typename F> auto gets(F f) {
+  return detail::makeState<S>(
+      [f](S& s) -> decltype(auto) { return f(static_cast<const S&>(s)); });
+}
+
+/**
+ * @return State updating the state with `f(s)`, with value Unit.
+ */
+template <typename S, typename F> auto modify(F f) {
+  return detail::makeState<S>([f](S& s) {
+    f(s);
+    return Unit();
+  });
+}
+// @}
+}  // namespace ma
@@ -0,0 +1,453 @@
+#pragma once
+
+#include "either.hpp"
+#include "executor.hpp"
+#include "maybe.hpp"
+#include "utils.h"
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ma {
+/**
+ * @defgroup Task Task
+ * @addtogroup Task
+ * @{
+ * Asynchronous counterpart of Either.
+ *
+ * ~~~
+ * template <class E, class T> class Task;
+ * ~~~
+ *
+ * A `Task<E, T>` eventually yields an `Either<E, T>`. Further computations are
+ * chained with `map`, `flatMap`, `leftMap` and `recover` without blocking;
+ * they run on the thread completing the task, or on an executor selected
+ * with `via`.
+ *
+ * Example
+ * -------
+ * ~~~
+ * ThreadPool pool;
+ * Task<std::string, Widget> widget =
+ *     async(pool, []() { return requestWidget(14.2, 3); });
+ * Task<std::string, BetterWidget> better =
+ *     std::move(widget).map([](Widget w) { return refine(w); });
+ * Either<std::string, BetterWidget> result = std::move(better).get();
+ * ~~~
+ *
+ * Functions passed to tasks must not throw, failures are reported through
+ * the left side.
+ */
+
+template <typename E, typename T> class Task;
+
+namespace detail {
+/**
+ * Shared state between the producer and the consumer of a task.
+ *
+ * Holds the result and the continuation, whichever is provided second runs
+ * the continuation. Each side performs a single CAS.
+ */
+template <typename E, typename T> class TaskState {
+ public:
+  using result_type = Either<E, T>;
+  using continuation_type = std::function<void(result_type&&)>;
+
+  void setResult(result_type&& r) {
+    result_.emplace(std::move(r));
+    int expected = empty;
+    if (!state_.compare_exchange_strong(expected, ready,
+                                        std::memory_order_acq_rel)) {
+      fire();
+    }
+  }
+
+  void setContinuation(continuation_type c) {
+    continuation_ = std::move(c);
+    int expected = empty;
+    if (!state_.compare_exchange_strong(expected, waiting,
+                                        std::memory_order_acq_rel)) {
+      fire();
+    }
+  }
+
+  bool isReady() const {
+    return state_.load(std::memory_order_acquire) == ready;
+  }
+
+ private:
+  enum : int { empty, ready, waiting };
+
+  void fire() {
+    auto c = std::move(continuation_);
+    c(std::move(result_.get()));
+  }
+
+  std::atomic<int> state_{empty};
+  Maybe<result_type> result_;
+  continuation_type continuation_;
+};
+}  // namespace detail
+
+/**
+ * Producer side of a Task.
+ *
+ * Copies refer to the same task; the result must be set exactly once.
+ */
+template <typename E, typename T> class Promise {
+ public:
+  Promise() : state_(std::make_shared<detail::TaskState<E, T>>()) {}
+
+  /**
+   * @return Task completed by this promise. Must be called at most once.
+   */
+  Task<E, T> getTask() const { return Task<E, T>(state_); }
+
+  /**
+   * Completes the task with `r`.
+   */
+  void set(Either<E, T> r) const { state_->setResult(std::move(r)); }
+
+  /**
+   * Completes the task with a right value.
+   */
+  void setValue(T t) const { set(Either<E, T>(Right, std::move(t))); }
+
+  /**
+   * Completes the task with a left value.
+   */
+  void setError(E e) const { set(Either<E, T>(Left, std::move(e))); }
+
+ private:
+  std::shared_ptr<detail::TaskState<E, T>> state_;
+};
+
+/**
+ * Asynchronous computation yielding either an `E` or a `T`.
+ *
+ * Tasks are move only. All operations other than `isReady` consume the
+ * task, i.e., a task can be continued only once.
+ */
+template <typename E, typename T> class MARJORAM_NODISCARD Task {
+ private:
+  using state_t = detail::TaskState<E, T>;
+
+ public:
+  using value_type = T;
+  using left_type = E;
+  using right_type = T;
+
+  Task(Task&&) = default;
+  Task& operator=(Task&&) = default;
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  /**
+   * @return true if the result is available. Only meaningful before the
+   * task is continued.
+   */
+  bool isReady() const { return state_->isReady(); }
+
+  /**
+   * Calls `f` with the result once it is available, on the completing
+   * thread (or the calling one, if already completed).
+   *
+   * @param f Function object. `F::operator()` callable with `Either<E, T>&&`.
+   */
+  template <typename F> void onComplete(F f) && {
+    auto state = std::move(state_);
+    state->setContinuation(std::move(f));
+  }
+
+  /**
+   * Applies supplied function to the right value once available.
+   *
+   * @param f Function object. `F::operator()` when called with `T` has
+   * non-void return type `R`.
+   *
+   * @return `Task<E, R>` containing either the pre-existing `E` or `f(t)`.
+   */
+  template <typename F> auto map(F f) && -> Task<E, std::result_of_t<F(T)>> {
+    using R = std::result_of_t<F(T)>;
+    auto next = std::make_shared<detail::TaskState<E, R>>();
+    std::move(*this).onComplete([next, f](Either<E, T>&& r) mutable {
+      next->setResult(std::move(r).map(f));
+    });
+    return Task<E, R>(next);
+  }
+
+  /**
+   * Continues with another task once the right value is available.
+   *
+   * @param f Function object. `F::operator()` when called with `T` has
+   * return type `Task<E, R>`.
+   *
+   * @return `Task<E, R>` containing either the pre-existing `E` or the
+   * result of the task returned by `f(t)`.
+   */
+  template <typename F> auto flatMap(F f) && -> std::result_of_t<F(T)> {
+    using TaskER = std::result_of_t<F(T)>;
+    using R = typename TaskER::right_type;
+    static_assert(std::is_same<TaskER, Task<E, R>>::value,
+                  "Task::flatMap f type mismatch.");
+    auto next = std::make_shared<detail::TaskState<E, R>>();
+    std::move(*this).onComplete([next, f](Either<E, T>&& r) mutable {
+      if (r.isRight()) {
+        f(std::move(r.asRight())).onComplete([next](Either<E, R>&& s) {
+          next->setResult(std::move(s));
+        });
+      } else {
+        next->setResult(Either<E, R>(Left, std::move(r.asLeft())));
+      }
+    });
+    return TaskER(next);
+  }
+
+  /**
+   * Applies supplied function to the left value once available.
+   *
+   * @param f Function object. `F::operator()` when called with `E` has
+   * non-void return type `C`.
+   *
+   * @return `Task<C, T>` containing either `f(e)` or the pre-existing `T`.
+   */
+  template <typename F>
+  auto leftMap(F f) && -> Task<std::result_of_t<F(E)>, T> {
+    using C = std::result_of_t<F(E)>;
+    auto next = std::make_shared<detail::TaskState<C, T>>();
+    std::move(*this).onComplete([next, f](Either<E, T>&& r) mutable {
+      next->setResult(std::move(r).leftMap(f));
+    });
+    return Task<C, T>(next);
+  }
+
+  /**
+   * Replaces a left value by a right value once available.
+   *
+   * @param f Function object. `F::operator()` when called with `E` has
+   * return type `T`.
+   *
+   * @return Task containing the right value or `f(e)`.
+   */
+  template <typename F> Task<E, T> recover(F f) && {
+    auto next = std::make_shared<state_t>();
+    std::move(*this).onComplete([next, f](Either<E, T>&& r) mutable {
+      if (r.isLeft()) {
+        next->setResult(Either<E, T>(Right, f(std::move(r.asLeft()))));
+      } else {
+        next->setResult(std::move(r));
+      }
+    });
+    return Task(next);
+  }
+
+  /**
+   * @return Task with the same result, whose continuations run on `ex`.
+   *
+   * @param ex Executor, must outlive the completion of this task.
+   */
+  template <typename Executor> Task via(Executor& ex) && {
+    auto next = std::make_shared<state_t>();
+    std::move(*this).onComplete([next, &ex](Either<E, T>&& r) {
+      /* std::function requires copyable function objects */
+      auto result = std::make_shared<Either<E, T>>(std::move(r));
+      ex.execute([next, result]() { next->setResult(std::move(*result)); });
+    });
+    return Task(next);
+  }
+
+  /**
+   * Blocks until the result is available.
+   * @return The result.
+   */
+  Either<E, T> get() && {
+    std::mutex mutex;
+    std::condition_variable cv;
+    Maybe<Either<E, T>> result;
+    std::move(*this).onComplete([&](Either<E, T>&& r) {
+      /* notify while locked, cv is destroyed once get returns */
+      std::lock_guard<std::mutex> lock(mutex);
+      result.emplace(std::move(r));
+      cv.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&result]() { return result.isJust(); });
+    return std::move(result.get());
+  }
+
+ private:
+  template <typename, typename> friend class Task;
+  friend class Promise<E, T>;
+  template <typename EE, typename TT>
+  friend Task<EE, TT> makeTask(Either<EE, TT> r);
+
+  explicit Task(std::shared_ptr<state_t> state) : state_(std::move(state)) {}
+
+  std::shared_ptr<state_t> state_;
+};
+
+/**
+ * @return Task that is already completed with `r`.
+ */
+template <typename E, typename T> Task<E, T> makeTask(Either<E, T> r) {
+  auto state = std::make_shared<detail::TaskState<E, T>>();
+  state->setResult(std::move(r));
+  return Task<E, T>(state);
+}
+
+/**
+ * Runs `f` on `ex`.
+ *
+ * @param f Function object. `F::operator()` called without arguments has
+ * return type `Either<E, T>`.
+ * @return Task completed with the result of `f()`.
+ */
+template <typename Executor, typename F>
+auto async(Executor& ex, F f)
+    -> Task<typename std::result_of_t<F()>::left_type,
+            typename std::result_of_t<F()>::right_type> {
+  using R = std::result_of_t<F()>;
+  Promise<typename R::left_type, typename R::right_type> promise;
+  auto task = promise.getTask();
+  ex.execute([promise, f]() mutable { promise.set(f()); });
+  return task;
+}
+
+namespace detail {
+template <typename E, typename... Ts> struct WhenAll {
+  template <std::size_t I>
+  using TypeAt = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+  WhenAll() : remaining(sizeof...(Ts)) {}
+
+  template <std::size_t I> void complete(Either<E, TypeAt<I>>&& r) {
+    if (r.isRight()) {
+      std::get<I>(slots).emplace(std::move(r.asRight()));
+    } else {
+      bool expected = false;
+      if (failed.compare_exchange_strong(expected, true,
+                                         std::memory_order_acq_rel)) {
+        promise.setError(std::move(r.asLeft()));
+      }
+    }
+    if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+        !failed.load(std::memory_order_acquire)) {
+      promise.setValue(collect(std::index_sequence_for<Ts...>()));
+    }
+  }
+
+  template <std::size_t... Is>
+  std::tuple<Ts...> collect(std::index_sequence<Is...>) {
+    return std::tuple<Ts...>(std::move(std::get<Is>(slots).get())...);
+  }
+
+  Promise<E, std::tuple<Ts...>> promise;
+  std::tuple<Maybe<Ts>...> slots;
+  std::atomic<std::size_t> remaining;
+  std::atomic<bool> failed{false};
+};
+
+template <typename E, typename... Ts, std::size_t... Is>
+Task<E, std::tuple<Ts...>> whenAll(std::index_sequence<Is...>,
+                                   Task<E, Ts>... tasks) {
+  auto join = std::make_shared<WhenAll<E, Ts...>>();
+  auto result = join->promise.getTask();
+  (void)std::initializer_list<int>{
+      (std::move(tasks).onComplete([join](Either<E, Ts>&& r) {
+        join->template complete<Is>(std::move(r));
+      }),
+       0)...};
+  return result;
+}
+}  // namespace detail
+
+/**
+ * @return Task containing the right values of all `tasks`, or the first left
+ * value to become available.
+ */
+template <typename E, typename... Ts>
+Task<E, std::tuple<Ts...>> whenAll(Task<E, Ts>... tasks) {
+  return detail::whenAll(std::index_sequence_for<Ts...>(), std::move(tasks)...);
+}
+
+/**
+ * @return Task containing the right values of all `tasks` in order, or the
+ * first left value to become available.
+ */
+template <typename E, typename T>
+Task<E, std::vector<T>> whenAll(std::vector<Task<E, T>> tasks) {
+  struct Join {
+    explicit Join(std::size_t n) : slots(n), remaining(n) {}
+
+    Promise<E, std::vector<T>> promise;
+    std::vector<Maybe<T>> slots;
+    std::atomic<std::size_t> remaining;
+    std::atomic<bool> failed{false};
+  };
+  if (tasks.empty()) {
+    return makeTask(Either<E, std::vector<T>>(Right));
+  }
+  auto join = std::make_shared<Join>(tasks.size());
+  auto result = join->promise.getTask();
+  for (std::size_t i = 0; i < tasks.size(); ++i) {
+    std::move(tasks[i]).onComplete([join, i](Either<E, T>&& r) {
+      if (r.isRight()) {
+        join->slots[i].emplace(std::move(r.asRight()));
+      } else {
+        bool expected = false;
+        if (join->failed.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acq_rel)) {
+          join->promise.setError(std::move(r.asLeft()));
+        }
+      }
+      if (join->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1 &&
+          !join->failed.load(std::memory_order_acquire)) {
+        std::vector<T> values;
+        values.reserve(join->slots.size());
+        for (auto& slot : join->slots) {
+          values.push_back(std::move(slot.get()));
+        }
+        join->promise.setValue(std::move(values));
+      }
+    });
+  }
+  return result;
+}
+
+/**
+ * @return Task containing the result of whichever of `tasks` completes
+ * first.
+ *
+ * `tasks` must not be empty.
+ */
+template <typename E, typename T>
+Task<E, T> whenAny(std::vector<Task<E, T>> tasks) {
+  assert(!tasks.empty());
+  struct Race {
+    Promise<E, T> promise;
+    std::atomic<bool> done{false};
+  };
+  auto race = std::make_shared<Race>();
+  auto result = race->promise.getTask();
+  for (auto& task : tasks) {
+    std::move(task).onComplete([race](Either<E, T>&& r) {
+      bool expected = false;
+      if (race->done.compare_exchange_strong(expected, true,
+                                             std::memory_order_acq_rel)) {
+        race->promise.set(std::move(r));
+      }
+    });
+  }
+  return result;
+}
+// @}
+}  // namespace ma
@@ -1,7 +1,92 @@
 #pragma once
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #if not defined(MARJORAM_ALLOW_DISCARD) && defined(__has_cpp_attribute) && \
     __has_cpp_attribute(nodiscard)
 #define MARJORAM_NODISCARD [[nodiscard]]
 #else
 #define MARJORAM_NODISCARD
 #endif
+
+/* standard vocabulary types marjoram converts to and from, if available */
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+#if defined(__cpp_lib_optional)
+#define MARJORAM_HAS_STD_OPTIONAL
+#include <optional>
+#endif
+#if defined(__cpp_lib_variant)
+#define MARJORAM_HAS_STD_VARIANT
+#include <variant>
+#endif
+#if defined(__cpp_lib_expected)
+#define MARJORAM_HAS_STD_EXPECTED
+#include <expected>
+#endif
+#if defined(__cpp_lib_three_way_comparison)
+#define MARJORAM_HAS_THREE_WAY_COMPARISON
+#include <compare>
+#endif
+
+namespace ma {
+namespace detail {
+/* number of occurrences of `T` in `Ts` */
+template <typename T, typename... Ts> struct CountOf {
+  static constexpr std::size_t value = 0;
+};
+
+template <typename T, typename T0, typename... Ts>
+struct CountOf<T, T0, Ts...> {
+  static constexpr std::size_t value =
+      (std::is_same<T, T0>::value ? 1 : 0) + CountOf<T, Ts...>::value;
+};
+
+template <bool... Bs>
+using AllOf = std::is_same<std::integer_sequence<bool, true, Bs...>,
+                           std::integer_sequence<bool, Bs..., true>>;
+
+inline std::size_t hashCombine(std::size_t seed, std::size_t h) {
+  /* as in boost::hash_combine */
+  return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+/**
+ * std::hash, extended to tuples and pairs.
+ */
+template <typename Key> struct PoolHash {
+  std::size_t operator()(const Key& key) const { return std::hash<Key>()(key); }
+};
+
+template <typename... Ts> struct PoolHash<std::tuple<Ts...>> {
+  std::size_t operator()(const std::tuple<Ts...>& key) const {
+    return combine(key, std::index_sequence_for<Ts...>());
+  }
+
+ private:
+  template <std::size_t... Is>
+  static std::size_t combine(const std::tuple<Ts...>& key,
+                             std::index_sequence<Is...>) {
+    std::size_t seed = 0;
+    /* in lieu of a fold expression */
+    (void)std::initializer_list<int>{
+        (seed = hashCombine(seed, PoolHash<std::decay_t<Ts>>()(
+                                      std::get<Is>(key))),
+         0)...};
+    return seed;
+  }
+};
+
+template <typename T, typename U> struct PoolHash<std::pair<T, U>> {
+  std::size_t operator()(const std::pair<T, U>& key) const {
+    return hashCombine(PoolHash<T>()(key.first), PoolHash<U>()(key.second));
+  }
+};
+}  // namespace detail
+}  // namespace ma
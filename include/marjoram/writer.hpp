@@ -0,0 +1,492 @@
+#pragma once
+
+#include "either.hpp"
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ma {
+/**
+ * @defgroup Writer Writer
+ * @addtogroup Writer
+ * @{
+ * Writer Monad, computations producing a value along with a log.
+ *
+ * ~~~
+ * template <class W, class T> class Writer;
+ * ~~~
+ *
+ * The log consists of entries of type `W`. It is a rope: appending an entry
+ * and combining the logs of two steps takes constant time, no matter how long
+ * the chain of computations.
+ *
+ * Example
+ * -------
+ * ~~~
+ * Writer<std::string, Widget> requestWidget(double length) {
+ *   return Writer<std::string, Widget>(Widget(length))
+ *       .tell("requested widget");
+ * }
+ *
+ * auto better = requestWidget(14.2).flatMap([](const Widget& w) {
+ *   return Writer<std::string, BetterWidget>(morph(w)).tell("morphed");
+ * });
+ * better.log().forEach([](const std::string& s) { std::clog << s << "\n"; });
+ * ~~~
+ *
+ * `Writer<Streamed<W>, T>` does not keep the log, its entries are streamed
+ * into a buffer of the thread producing them instead, see LogStream.
+ */
+
+/**
+ * Persistent sequence of log entries supporting constant time append and
+ * concatenation.
+ *
+ * Copies share their entries, which are never modified.
+ */
+template <typename W> class Log {
+  static_assert(std::is_same<std::decay_t<W>, W>::value,
+                "Log<W>: W must be a value type.");
+
+ public:
+  using value_type = W;
+
+  Log() = default;
+
+  Log(std::initializer_list<W> entries) {
+    if (entries.size()) {
+      root_ = std::make_shared<Node>();
+      root_->entries = entries;
+      root_->size = entries.size();
+    }
+  }
+
+  std::size_t size() const { return root_ ? root_->size : 0; }
+
+  bool empty() const { return !root_; }
+
+  /**
+   * @return Log followed by `w`.
+   */
+  Log append(W w) const& { return Log(*this).append(std::move(w)); }
+
+  /**
+   * Appends in place to the last chunk when it is not shared.
+   */
+  Log append(W w) && {
+    Node* chunk = unsharedChunk();
+    if (chunk) {
+      chunk->entries.push_back(std::move(w));
+      for (Node* n = root_.get(); n != chunk; n = n->right.get()) {
+        n->size++;
+      }
+      chunk->size++;
+      return std::move(*this);
+    }
+    auto leaf = std::make_shared<Node>();
+    leaf->entries.push_back(std::move(w));
+    leaf->size = 1;
+    return std::move(*this).concat(Log(std::move(leaf)));
+  }
+
+  /**
+   * @return Log followed by `other`.
+   */
+  Log concat(const Log& other) const {
+    if (!root_) {
+      return other;
+    }
+    if (!other.root_) {
+      return *this;
+    }
+    auto node = std::make_shared<Node>();
+    node->left = root_;
+    node->right = other.root_;
+    node->size = root_->size + other.root_->size;
+    return Log(std::move(node));
+  }
+
+  /**
+   * Calls `f` with every entry, in order.
+   */
+  template <typename F> void forEach(F f) const {
+    /* iterative, logs of long chains are deep */
+    std::vector<const Node*> pending;
+    if (root_) {
+      pending.push_back(root_.get());
+    }
+    while (!pending.empty()) {
+      const Node* n = pending.back();
+      pending.pop_back();
+      if (n->left) {
+        pending.push_back(n->right.get());
+        pending.push_back(n->left.get());
+      } else {
+        for (const auto& w : n->entries) {
+          f(w);
+        }
+      }
+    }
+  }
+
+  std::vector<W> toVector() const {
+    std::vector<W> entries;
+    entries.reserve(size());
+    forEach([&entries](const W& w) { entries.push_back(w); });
+    return entries;
+  }
+
+ private:
+  /* either a chunk of entries, or the concatenation of two nodes */
+  struct Node {
+    Node() = default;
+    Node(const Node&) = delete;
+
+    ~Node() {
+      /* unlinks unshared descendants iteratively, rather than recursing */
+      std::vector<std::shared_ptr<Node>> orphans;
+      auto release = [&orphans](std::shared_ptr<Node>& n) {
+        if (n && n.use_count() == 1) {
+          orphans.push_back(std::move(n));
+        }
+      };
+      release(left);
+      release(right);
+      while (!orphans.empty()) {
+        auto n = std::move(orphans.back());
+        orphans.pop_back();
+        release(n->left);
+        release(n->right);
+      }
+    }
+
+    std::vector<W> entries;
+    std::shared_ptr<Node> left;
+    std::shared_ptr<Node> right;
+    std::size_t size = 0;
+  };
+
+  explicit Log(std::shared_ptr<Node> root) : root_(std::move(root)) {}
+
+  /* last chunk, if neither it nor any node leading to it is shared */
+  Node* unsharedChunk() {
+    Node* n = root_.get();
+    if (!n || root_.use_count() != 1) {
+      return nullptr;
+    }
+    while (n->right) {
+      if (n->right.use_count() != 1) {
+        return nullptr;
+      }
+      n = n->right.get();
+    }
+    return n;
+  }
+
+  std::shared_ptr<Node> root_;
+};
+
+/**
+ * Single producer, single consumer ring buffer of log entries.
+ *
+ * When full, new entries are dropped and counted.
+ *
+ * Type requirement:
+ * - `W` is default constructible and move assignable.
+ */
+template <typename W> class LogRing {
+ public:
+  /**
+   * @param capacity Rounded up to a power of two.
+   */
+  explicit LogRing(std::size_t capacity)
+      : mask_(roundUp(capacity) - 1), entries_(mask_ + 1) {}
+
+  LogRing(const LogRing&) = delete;
+  LogRing& operator=(const LogRing&) = delete;
+
+  /**
+   * Called by the producer only.
+   *
+   * @return false iff the ring was full and `w` dropped.
+   */
+  bool push(W w) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) > mask_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    entries_[tail & mask_] = std::move(w);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Called by the consumer only, passes the entries pushed so far to `f` as
+   * rvalues.
+   *
+   * @return Number of entries drained.
+   */
+  template <typename F> std::size_t drain(F& f) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    const std::size_t tail = tail_.load(std::memory_order_acquire);
+    for (std::size_t i = head; i != tail; ++i) {
+      f(std::move(entries_[i & mask_]));
+    }
+    head_.store(tail, std::memory_order_release);
+    return tail - head;
+  }
+
+  std::size_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static std::size_t roundUp(std::size_t n) {
+    std::size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  const std::size_t mask_;
+  std::vector<W> entries_;
+  std::atomic<std::size_t> head_{0};
+  std::atomic<std::size_t> tail_{0};
+  std::atomic<std::size_t> dropped_{0};
+};
+
+/**
+ * Log entries of type `W` streamed by Writer<Streamed<W>, T>.
+ *
+ * Every thread appends to its own LogRing without locking; `drain` collects
+ * the entries of all threads, including ones that exited since.
+ */
+template <typename W> class LogStream {
+ public:
+  /** Entries buffered per thread before new ones are dropped. */
+  static constexpr std::size_t capacity = 4096;
+
+  /**
+   * @return Ring of the calling thread.
+   */
+  static LogRing<W>& local() {
+    static thread_local const std::shared_ptr<LogRing<W>> ring = add();
+    return *ring;
+  }
+
+  /**
+   * Passes buffered entries to `f` as rvalues, in order per thread. Only
+   * one thread drains at a time.
+   *
+   * @return Number of entries drained.
+   */
+  template <typename F> static std::size_t drain(F f) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::size_t n = 0;
+    for (auto it = r.rings.begin(); it != r.rings.end();) {
+      n += (*it)->drain(f);
+      /* forget rings of exited threads */
+      if (it->use_count() == 1) {
+        r.dropped += (*it)->dropped();
+        it = r.rings.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    return n;
+  }
+
+  /**
+   * @return Number of entries dropped because a ring was full.
+   */
+  static std::size_t dropped() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    std::size_t n = r.dropped;
+    for (const auto& ring : r.rings) {
+      n += ring->dropped();
+    }
+    return n;
+  }
+
+ private:
+  struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<LogRing<W>>> rings;
+    std::size_t dropped = 0;
+  };
+
+  static Registry& registry() {
+    static Registry r;
+    return r;
+  }
+
+  static std::shared_ptr<LogRing<W>> add() {
+    auto ring = std::make_shared<LogRing<W>>(capacity);
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.rings.push_back(ring);
+    return ring;
+  }
+};
+
+template <typename W> constexpr std::size_t LogStream<W>::capacity;
+
+/**
+ * Tag selecting a Writer streaming entries of type `W` into LogStream<W>.
+ */
+template <typename W> struct Streamed {};
+
+/**
+ * Log of a Writer<Streamed<W>, T>, which keeps nothing.
+ */
+template <typename W> class StreamedLog {
+ public:
+  using value_type = W;
+
+  StreamedLog append(W w) const {
+    LogStream<W>::local().push(std::move(w));
+    return *this;
+  }
+
+  StreamedLog concat(const StreamedLog&) const { return *this; }
+};
+
+namespace detail {
+template <typename W> struct WriterLog {
+  using type = Log<W>;
+};
+
+template <typename W> struct WriterLog<Streamed<W>> {
+  using type = StreamedLog<W>;
+};
+}  // namespace detail
+
+/**
+ * Writer monad.
+ *
+ * Holds a value of type `T` and the log of its computation.
+ *
+ * Type requirements:
+ *  T must be a value type
+ */
+template <typename W, typename T> class Writer {
+  static_assert(std::is_same<std::decay_t<T>, T>::value,
+                "Writer<W, T>: T must be a value type.");
+
+ public:
+  using log_type = typename detail::WriterLog<W>::type;
+  using entry_type = typename log_type::value_type;
+  using value_type = T;
+
+  explicit Writer(T value, log_type log = log_type())
+      : value_(std::move(value)), log_(std::move(log)) {}
+
+  const T& value() const& { return value_; }
+  T value() && { return std::move(value_); }
+
+  const log_type& log() const { return log_; }
+
+  /**
+   * @return Writer with `w` appended to the log.
+   */
+  Writer tell(entry_type w) const& {
+    return Writer(value_, log_.append(std::move(w)));
+  }
+
+  Writer tell(entry_type w) && {
+    return Writer(std::move(value_), std::move(log_).append(std::move(w)));
+  }
+
+  /**
+   * @param f Function object.
+   *
+   * Type requirement:
+   * - `F::operator()` when called with `const T&` argument has non-void
+   *   return type `C`.
+   *
+   * @return `Writer<W, C>` with the same log.
+   */
+  template <typename F>
+  auto map(F f) const& -> Writer<W, std::result_of_t<F(const T&)>> {
+    return Writer<W, std::result_of_t<F(const T&)>>(f(value_), log_);
+  }
+
+  template <typename F>
+  auto map(F f) && -> Writer<W, std::result_of_t<F(T)>> {
+    return Writer<W, std::result_of_t<F(T)>>(f(std::move(value_)),
+                                             std::move(log_));
+  }
+
+  /**
+   * @param f Function object.
+   *
+   * Type requirement:
+   * - `F::operator()` when called with `const T&` argument returns
+   *   `Writer<W, C>`.
+   *
+   * @return `Writer<W, C>`, whose log is this log followed by that of the
+   * result of `f`.
+   */
+  template <typename F>
+  auto flatMap(F f) const& -> std::result_of_t<F(const T&)> {
+    auto r = f(value_);
+    return combine(log_, std::move(r));
+  }
+
+  template <typename F> auto flatMap(F f) && -> std::result_of_t<F(T)> {
+    auto r = f(std::move(value_));
+    return combine(log_, std::move(r));
+  }
+
+  /**
+   * Maps the right value of a `Writer<W, Either<E, B>>`.
+   *
+   * @return `Writer<W, Either<E, C>>` with the same log.
+   */
+  template <typename F, typename TT = T>
+  auto mapRight(F f) const
+      -> Writer<W, decltype(std::declval<const TT&>().map(f))> {
+    return Writer<W, decltype(value_.map(f))>(value_.map(f), log_);
+  }
+
+  /**
+   * Continues a `Writer<W, Either<E, B>>` with its right value.
+   *
+   * Type requirement:
+   * - `F::operator()` when called with `const B&` argument returns
+   *   `Writer<W, Either<E, C>>`.
+   *
+   * @return Result of `f` with this log prepended, or the left value along
+   * with the log so far.
+   */
+  template <typename F, typename TT = T>
+  auto flatMapRight(F f) const
+      -> std::result_of_t<F(const typename TT::right_type&)> {
+    using R = std::result_of_t<F(const typename TT::right_type&)>;
+    using C = typename R::value_type::right_type;
+    if (value_.isLeft()) {
+      return R(Either<typename TT::left_type, C>(Left, value_.asLeft()), log_);
+    }
+    return combine(log_, f(value_.asRight()));
+  }
+
+ private:
+  template <typename C>
+  static Writer<W, C> combine(const log_type& log, Writer<W, C>&& r) {
+    return Writer<W, C>(std::move(r).value(), log.concat(r.log()));
+  }
+
+  T value_;
+  log_type log_;
+};
+// @}
+}  // namespace ma
@@ -0,0 +1,108 @@
+#include "marjoram/ambient.hpp"
+#include "marjoram/task.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+using ma::AmbientScope;
+using ma::Either;
+using ma::Reader;
+using ma::ThreadPool;
+
+namespace {
+struct Services {
+  Services(std::string name_) : name(std::move(name_)) {}
+  Services(const Services& other) : name(other.name) { copies++; }
+
+  std::string name;
+  static std::atomic<int> copies;
+};
+std::atomic<int> Services::copies(0);
+
+struct RequestId {
+  int value;
+};
+
+Reader<Services, std::string> serviceName() {
+  return Reader<Services, std::string>(
+      [](const Services& s) { return s.name; });
+}
+}  // namespace
+
+TEST(Ambient, scopesNest) {
+  ASSERT_FALSE(ma::ambient<Services>());
+  {
+    AmbientScope<Services> outer(std::make_shared<const Services>("outer"));
+    ASSERT_EQ(ma::runAmbient(serviceName()), "outer");
+    {
+      AmbientScope<Services> inner(std::make_shared<const Services>("inner"));
+      AmbientScope<RequestId> id(std::make_shared<const RequestId>(
+          RequestId{7}));
+      ASSERT_EQ(ma::runAmbient(serviceName()), "inner");
+      ASSERT_EQ(ma::ambient<RequestId>()->value, 7);
+    }
+    ASSERT_EQ(ma::runAmbient(serviceName()), "outer");
+    ASSERT_FALSE(ma::ambient<RequestId>());
+  }
+  ASSERT_FALSE(ma::ambient<Services>());
+}
+
+TEST(Ambient, propagatesAcrossThreads) {
+  ThreadPool pool(2);
+  auto executor = ma::propagating<Services>(pool);
+  auto services = std::make_shared<const Services>("shared");
+  Services::copies = 0;
+
+  ma::Task<std::string, std::string> task = [&]() {
+    AmbientScope<Services> scope(services);
+    return ma::async(executor, []() {
+      return Either<std::string, std::string>(ma::Right,
+                                              ma::runAmbient(serviceName()));
+    });
+  }();
+  ASSERT_EQ(std::move(task).get().asRight(), "shared");
+  ASSERT_EQ(Services::copies, 0);
+
+  /* without a scope, functions run without an environment */
+  auto none = ma::async(executor, []() {
+    return Either<std::string, bool>(ma::Right,
+                                     !ma::ambient<Services>());
+  });
+  ASSERT_TRUE(std::move(none).get().asRight());
+}
+
+TEST(Ambient, sharesEnvironmentUntilFunctionsRan) {
+  ThreadPool pool(1);
+  ma::PropagatingExecutor<RequestId, ThreadPool> inner(pool);
+  ma::PropagatingExecutor<Services, decltype(inner)> executor(inner);
+
+  std::atomic<bool> release(false);
+  std::atomic<bool> ran(false);
+  std::weak_ptr<const Services> watch;
+  {
+    auto services = std::make_shared<const Services>("kept");
+    watch = services;
+    AmbientScope<Services> scope(std::move(services));
+    AmbientScope<RequestId> id(std::make_shared<const RequestId>(
+        RequestId{3}));
+    executor.execute([&]() {
+      while (!release) {
+        std::this_thread::yield();
+      }
+      ASSERT_EQ(ma::ambient<Services>()->name, "kept");
+      ASSERT_EQ(ma::ambient<RequestId>()->value, 3);
+      ran = true;
+    });
+  }
+  ASSERT_FALSE(watch.expired());
+  release = true;
+  while (!ran) {
+    std::this_thread::yield();
+  }
+  /* the worker drops its reference after the function returned */
+  while (!watch.expired()) {
+    std::this_thread::yield();
+  }
+}
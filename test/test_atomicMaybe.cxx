@@ -0,0 +1,165 @@
+#include "marjoram/atomicMaybe.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+using ma::AtomicMaybe;
+using ma::Just;
+using ma::Maybe;
+using ma::Nothing;
+
+namespace {
+struct Small {
+  std::uint16_t a, b, c;
+};
+
+struct Word {
+  std::uint32_t a, b;
+};
+
+struct Large {
+  std::uint64_t a, b, c, d, e;
+};
+
+Small small(std::uint16_t x) { return Small{x, x, x}; }
+Word word(std::uint32_t x) { return Word{x, x}; }
+Large large(std::uint64_t x) { return Large{x, x, x, x, x}; }
+
+bool consistent(const Small& s) { return s.a == s.b && s.b == s.c; }
+bool consistent(const Word& w) { return w.a == w.b; }
+bool consistent(const Large& l) {
+  return l.a == l.b && l.b == l.c && l.c == l.d && l.d == l.e;
+}
+
+const unsigned threads = 8;
+const unsigned perThread = 2000;
+
+/*
+ * Producers publish distinct values whenever the slot is empty, consumers
+ * take them. Every value must be taken exactly once, and untorn.
+ */
+template <typename T, typename Make> void handOver(Make make) {
+  AtomicMaybe<T> slot;
+  std::vector<std::atomic<int>> taken(threads * perThread);
+  for (auto& t : taken) {
+    t.store(0);
+  }
+  std::atomic<unsigned> remaining(threads * perThread);
+  std::atomic<bool> torn(false);
+
+  std::vector<std::thread> workers;
+  for (unsigned p = 0; p < threads / 2; ++p) {
+    workers.emplace_back([&, p]() {
+      for (unsigned i = 0; i < 2 * perThread; ++i) {
+        const Maybe<T> value = make(p * 2 * perThread + i);
+        while (!slot.compareAndSet(Nothing, value)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (unsigned c = 0; c < threads / 2; ++c) {
+    workers.emplace_back([&]() {
+      while (remaining.load() > 0) {
+        const Maybe<T> seen = slot.load();
+        torn = torn || (seen.isJust() && !consistent(seen.get()));
+        const Maybe<T> took = slot.take();
+        if (took.isNothing()) {
+          std::this_thread::yield();
+          continue;
+        }
+        torn = torn || !consistent(took.get());
+        taken[took.get().a]++;
+        remaining--;
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  ASSERT_FALSE(torn);
+  for (auto& t : taken) {
+    ASSERT_EQ(t.load(), 1);
+  }
+}
+}  // namespace
+
+TEST(AtomicMaybe, packedOperations) {
+  AtomicMaybe<int> slot;
+  ASSERT_TRUE(slot.isLockFree());
+  ASSERT_TRUE(slot.load().isNothing());
+
+  slot.store(5);
+  ASSERT_EQ(slot.load(), Just(5));
+  ASSERT_FALSE(slot.compareAndSet(Nothing, Just(6)));
+  ASSERT_TRUE(slot.compareAndSet(Just(5), Just(0)));
+  /* zero is distinguished from Nothing */
+  ASSERT_EQ(slot.exchange(Just(7)), Just(0));
+  ASSERT_EQ(slot.take(), Just(7));
+  ASSERT_TRUE(slot.take().isNothing());
+}
+
+TEST(AtomicMaybe, lockFreeTypes) {
+  static_assert(!AtomicMaybe<Large>::isAlwaysLockFree,
+                "larger types use a sequence lock");
+#ifdef MARJORAM_HAS_DOUBLE_WORD_CAS
+  static_assert(AtomicMaybe<std::int64_t>::isAlwaysLockFree,
+                "word sized types are lock free");
+  static_assert(AtomicMaybe<double>::isAlwaysLockFree,
+                "word sized types are lock free");
+  static_assert(AtomicMaybe<const void*>::isAlwaysLockFree,
+                "word sized types are lock free");
+  ASSERT_TRUE(AtomicMaybe<double>().isLockFree());
+#endif
+  ASSERT_FALSE(AtomicMaybe<Large>().isLockFree());
+}
+
+TEST(AtomicMaybe, wordOperations) {
+  AtomicMaybe<std::int64_t> slot;
+  ASSERT_TRUE(slot.load().isNothing());
+
+  slot.store(Just<std::int64_t>(-1));
+  ASSERT_EQ(slot.load(), Just<std::int64_t>(-1));
+  ASSERT_FALSE(slot.compareAndSet(Nothing, Just<std::int64_t>(6)));
+  ASSERT_FALSE(
+      slot.compareAndSet(Just<std::int64_t>(5), Just<std::int64_t>(6)));
+  ASSERT_TRUE(
+      slot.compareAndSet(Just<std::int64_t>(-1), Just<std::int64_t>(0)));
+  /* zero is distinguished from Nothing */
+  ASSERT_EQ(slot.exchange(Just<std::int64_t>(7)), Just<std::int64_t>(0));
+  ASSERT_EQ(slot.take(), Just<std::int64_t>(7));
+  ASSERT_TRUE(slot.take().isNothing());
+  ASSERT_TRUE(slot.compareAndSet(Nothing, Just<std::int64_t>(8)));
+  ASSERT_EQ(slot.load(), Just<std::int64_t>(8));
+}
+
+TEST(AtomicMaybe, seqlockOperations) {
+  AtomicMaybe<Large> slot(large(1));
+  ASSERT_FALSE(slot.isLockFree());
+  ASSERT_EQ(slot.load().get().e, 1u);
+
+  ASSERT_FALSE(slot.compareAndSet(Nothing, Just(large(2))));
+  ASSERT_FALSE(slot.compareAndSet(Just(large(3)), Just(large(2))));
+  ASSERT_TRUE(slot.compareAndSet(Just(large(1)), Just(large(2))));
+  ASSERT_EQ(slot.exchange(Just(large(4))).get().e, 2u);
+  ASSERT_EQ(slot.take().get().e, 4u);
+  ASSERT_TRUE(slot.take().isNothing());
+  ASSERT_TRUE(slot.load().isNothing());
+  ASSERT_TRUE(slot.compareAndSet(Nothing, Just(large(5))));
+  ASSERT_EQ(slot.load().get().a, 5u);
+}
+
+TEST(AtomicMaybe, packedStress) {
+  handOver<Small>([](unsigned i) { return small(std::uint16_t(i)); });
+}
+
+TEST(AtomicMaybe, wordStress) {
+  handOver<Word>([](unsigned i) { return word(i); });
+}
+
+TEST(AtomicMaybe, seqlockStress) {
+  handOver<Large>([](unsigned i) { return large(i); });
+}
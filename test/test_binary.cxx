@@ -0,0 +1,114 @@
+#include "marjoram/binary.hpp"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+using ma::Either;
+using ma::Encoding;
+using ma::Left;
+using ma::Maybe;
+using ma::Right;
+
+namespace {
+struct Point {
+  float x;
+  float y;
+};
+
+bool operator==(const Point& lhs, const Point& rhs) {
+  return lhs.x == rhs.x && lhs.y == rhs.y;
+}
+
+using Nested = Either<std::int16_t, Maybe<Either<double, Point>>>;
+
+Nested randomNested(std::mt19937& rng) {
+  std::uniform_int_distribution<int> choice(0, 3);
+  std::uniform_real_distribution<double> real(-1e6, 1e6);
+  switch (choice(rng)) {
+    case 0:
+      return Nested(Left, static_cast<std::int16_t>(rng()));
+    case 1:
+      return Nested(Right, ma::Nothing);
+    case 2:
+      return Nested(Right, Maybe<Either<double, Point>>(
+                               Either<double, Point>(Left, real(rng))));
+    default:
+      return Nested(Right, Maybe<Either<double, Point>>(Either<double, Point>(
+                               Right, Point{float(real(rng)), 1.f})));
+  }
+}
+
+template <typename T> std::vector<unsigned char> encoded(const T& t) {
+  std::vector<unsigned char> buffer(Encoding<T>::size);
+  ma::encode(t, buffer.data());
+  return buffer;
+}
+}  // namespace
+
+TEST(Binary, layout) {
+  static_assert(Encoding<Maybe<double>>::size == 16, "tag padded to 8");
+  static_assert(Encoding<Maybe<char>>::size == 2, "tag and payload");
+  static_assert(Encoding<Either<char, std::int32_t>>::size == 8,
+                "room for the larger alternative");
+  static_assert(Encoding<Nested>::alignment == 8, "largest alignment");
+
+  ASSERT_EQ(encoded(Maybe<int>()), encoded(Maybe<int>()));
+  ASSERT_NE(encoded(Maybe<int>()), encoded(Maybe<int>(0)));
+}
+
+TEST(Binary, view) {
+  const Nested point(Right, Maybe<Either<double, Point>>(
+                                Either<double, Point>(Right, Point{1, 2})));
+  auto buffer = encoded(point);
+
+  auto view = ma::view<Nested>(buffer.data());
+  ASSERT_TRUE(view.isRight());
+  ASSERT_TRUE(view.asRight().isJust());
+  ASSERT_EQ(view.asRight().get().asRight().y, 2.f);
+  ASSERT_EQ(ma::decode<Nested>(buffer.data()), point);
+}
+
+TEST(Binary, fuzz) {
+  std::mt19937 rng(71);
+  for (int round = 0; round < 200; ++round) {
+    std::vector<Nested> values;
+    const std::size_t n = rng() % 40;
+    for (std::size_t i = 0; i < n; ++i) {
+      values.push_back(randomNested(rng));
+    }
+
+    for (const auto& value : values) {
+      ASSERT_EQ(ma::decode<Nested>(encoded(value).data()), value);
+    }
+
+    std::vector<unsigned char> buffer(ma::encodedRangeSize<Nested>(n));
+    ASSERT_EQ(ma::encodeRange(values.begin(), values.end(), buffer.data()),
+              buffer.size());
+    ma::RangeView<Nested> view(buffer.data(), n);
+    ASSERT_EQ(view.size(), n);
+    std::vector<Nested> decoded;
+    view.decode(std::back_inserter(decoded));
+    ASSERT_EQ(decoded, values);
+    for (std::size_t i = 0; i < n; ++i) {
+      ASSERT_EQ(view[i].isRight(), values[i].isRight());
+    }
+  }
+}
+
+TEST(Binary, packedTags) {
+  std::vector<Maybe<std::int32_t>> values;
+  for (int i = 0; i < 17; ++i) {
+    values.push_back(i % 3 ? Maybe<std::int32_t>(i) : ma::Nothing);
+  }
+  std::vector<unsigned char> buffer(
+      ma::encodedRangeSize<Maybe<std::int32_t>>(values.size()));
+  ASSERT_EQ(buffer.size(), 4 + 17 * 4u);
+  ma::encodeRange(values.begin(), values.end(), buffer.data());
+
+  ma::RangeView<Maybe<std::int32_t>> view(buffer.data(), values.size());
+  ASSERT_EQ(buffer[0], 0xb6);
+  ASSERT_TRUE(view[16].isJust());
+  ASSERT_EQ(view[16].get(), 16);
+  ASSERT_TRUE(view[15].isNothing());
+}
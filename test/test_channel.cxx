@@ -0,0 +1,161 @@
+#include "marjoram/channel.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ma::Channel;
+using ma::Either;
+using ma::Left;
+using ma::Right;
+
+TEST(Channel, fifo) {
+  Channel<int> ch(3);
+  ASSERT_EQ(ch.capacity(), 4u);
+  ASSERT_TRUE(ch.tryPop().isNothing());
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_TRUE(ch.tryPush(i));
+  }
+  ASSERT_FALSE(ch.tryPush(4));
+  ASSERT_EQ(ch.tryPop().get(), 0);
+  ASSERT_TRUE(ch.tryPush(4));
+  for (int i = 1; i < 5; ++i) {
+    ASSERT_EQ(ch.pop().asRight(), i);
+  }
+  ASSERT_TRUE(ch.tryPop().isNothing());
+}
+
+TEST(Channel, failedPushKeepsValue) {
+  Channel<std::unique_ptr<int>> ch(2);
+  ASSERT_TRUE(ch.tryPush(std::make_unique<int>(1)));
+  ASSERT_TRUE(ch.tryPush(std::make_unique<int>(2)));
+  auto three = std::make_unique<int>(3);
+  ASSERT_FALSE(ch.tryPush(std::move(three)));
+  ASSERT_EQ(*three, 3);
+}
+
+TEST(Channel, closeDrains) {
+  Channel<std::string> ch(4);
+  ASSERT_TRUE(ch.push("a"));
+  ASSERT_TRUE(ch.push("b"));
+  ch.close();
+  ASSERT_TRUE(ch.isClosed());
+  ASSERT_FALSE(ch.push("c"));
+  ASSERT_FALSE(ch.tryPush("c"));
+  ASSERT_EQ(ch.pop().asRight(), "a");
+  ASSERT_EQ(ch.tryPop().get(), "b");
+  ASSERT_TRUE(ch.pop().isLeft());
+  ASSERT_TRUE(ch.pop().isLeft());
+}
+
+TEST(Channel, closeWakesConsumers) {
+  Channel<int> ch(4);
+  std::thread consumer([&ch]() { ASSERT_TRUE(ch.pop().isLeft()); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ch.close();
+  consumer.join();
+}
+
+TEST(Channel, batches) {
+  Channel<int> ch(4);
+  std::vector<int> in{1, 2, 3, 4, 5, 6};
+  auto rest = ch.tryPushBatch(in.begin(), in.end());
+  ASSERT_EQ(rest - in.begin(), 4);
+
+  std::vector<int> out;
+  ASSERT_EQ(ch.tryPopBatch(std::back_inserter(out), 3), 3u);
+  ASSERT_EQ(out, (std::vector<int>{1, 2, 3}));
+  rest = ch.tryPushBatch(rest, in.end());
+  ASSERT_TRUE(rest == in.end());
+  ASSERT_EQ(ch.popBatch(std::back_inserter(out), 10).asRight(), 3u);
+  ASSERT_EQ(out, in);
+
+  ch.close();
+  ASSERT_TRUE(ch.popBatch(std::back_inserter(out), 10).isLeft());
+}
+
+TEST(Channel, destroysRemainingValues) {
+  auto counted = std::make_shared<int>(0);
+  {
+    Channel<std::shared_ptr<int>> ch(8);
+    ASSERT_TRUE(ch.push(counted));
+    ASSERT_TRUE(ch.push(counted));
+    ASSERT_EQ(counted.use_count(), 3);
+  }
+  ASSERT_EQ(counted.use_count(), 1);
+}
+
+TEST(Channel, manyProducersAndConsumers) {
+  using Message = Either<std::string, int>;
+  const int producers = 4;
+  const int consumers = 4;
+  const int perProducer = 2000;
+
+  Channel<Message> ch(16);
+  std::vector<std::atomic<int>> received(producers * perProducer);
+  for (auto& r : received) {
+    r.store(0);
+  }
+  std::atomic<int> errors(0);
+
+  std::vector<std::thread> threads;
+  for (int p = 0; p < producers; ++p) {
+    threads.emplace_back([&, p]() {
+      std::vector<Message> batch;
+      for (int i = 0; i < perProducer; ++i) {
+        const int n = p * perProducer + i;
+        if (n % 7 == 0) {
+          batch.emplace_back(Left, std::to_string(n));
+        } else {
+          batch.emplace_back(Right, n);
+        }
+        if (batch.size() == 5) {
+          ASSERT_TRUE(ch.pushBatch(batch.begin(), batch.end()));
+          batch.clear();
+        }
+      }
+      for (auto& m : batch) {
+        ASSERT_TRUE(ch.push(std::move(m)));
+      }
+    });
+  }
+  for (int c = 0; c < consumers; ++c) {
+    threads.emplace_back([&, c]() {
+      std::vector<Message> batch;
+      while (true) {
+        if (c % 2) {
+          auto m = ch.pop();
+          if (m.isLeft()) {
+            return;
+          }
+          batch.push_back(std::move(m.asRight()));
+        } else if (ch.popBatch(std::back_inserter(batch), 8).isLeft()) {
+          return;
+        }
+        for (auto& m : batch) {
+          if (m.isLeft()) {
+            errors++;
+            received[std::stoi(m.asLeft())]++;
+          } else {
+            received[m.asRight()]++;
+          }
+        }
+        batch.clear();
+      }
+    });
+  }
+  for (int p = 0; p < producers; ++p) {
+    threads[p].join();
+  }
+  ch.close();
+  for (int c = 0; c < consumers; ++c) {
+    threads[producers + c].join();
+  }
+
+  for (auto& r : received) {
+    ASSERT_EQ(r.load(), 1);
+  }
+  ASSERT_EQ(errors, (producers * perProducer + 6) / 7);
+}
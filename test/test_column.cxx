@@ -0,0 +1,143 @@
+#include "marjoram/column.hpp"
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using ma::Either;
+using ma::Left;
+using ma::Maybe;
+using ma::Nothing;
+using ma::Right;
+
+namespace {
+std::string columnPath(const char* name) {
+  return testing::TempDir() + "marjoram_" + name + ".col";
+}
+}  // namespace
+
+TEST(Column, maybe) {
+  std::vector<Maybe<double>> rows;
+  for (int i = 0; i < 1500; ++i) {
+    rows.push_back(i % 3 == 0 ? Maybe<double>() : Maybe<double>(i * 0.5));
+  }
+  const auto path = columnPath("maybe");
+  auto written = ma::writeColumn(path, rows.begin(), rows.end());
+  ASSERT_TRUE(written.isRight());
+  ASSERT_EQ(written.asRight() % 64, 0u);
+
+  auto opened = ma::openMaybeColumn<double>(path);
+  ASSERT_TRUE(opened.isRight());
+  const auto& column = opened.asRight();
+  ASSERT_EQ(column.size(), rows.size());
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(column.values()) % 64, 0u);
+  for (std::size_t i : {0u, 1u, 2u, 511u, 512u, 513u, 1499u}) {
+    ASSERT_EQ(column[i].isJust(), rows[i].isJust());
+    if (rows[i].isJust()) {
+      ASSERT_EQ(column[i].get(), rows[i].get());
+    }
+  }
+
+  auto doubled = column.map([](double d) { return 2 * d; });
+  ASSERT_EQ(doubled[4], Maybe<double>(4.0));
+  ASSERT_TRUE(doubled[3].isNothing());
+  auto large = column.filter([](double d) { return d > 100; });
+  ASSERT_TRUE(large[4].isNothing());
+  ASSERT_EQ(large[1000], rows[1000]);
+  auto filled = column.getOrElse(-1);
+  ASSERT_EQ(filled[0], -1);
+  ASSERT_EQ(filled[1499], 749.5);
+  std::remove(path.c_str());
+}
+
+TEST(Column, either) {
+  std::vector<Either<std::int32_t, float>> rows;
+  for (int i = 0; i < 700; ++i) {
+    rows.push_back(i % 5 == 0 ? Either<std::int32_t, float>(Left, -i)
+                              : Either<std::int32_t, float>(Right, i));
+  }
+  const auto path = columnPath("either");
+  ASSERT_TRUE(ma::writeColumn(path, rows.begin(), rows.end()).isRight());
+
+  auto opened = ma::openEitherColumn<std::int32_t, float>(path);
+  ASSERT_TRUE(opened.isRight());
+  const auto& column = opened.asRight();
+  ASSERT_EQ(column.size(), rows.size());
+  ASSERT_EQ(column[695].asLeft(), -695);
+  ASSERT_EQ(column[699].asRight(), 699.f);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(column.lefts()) % 64, 0u);
+
+  auto halves = column.map([](float f) { return f / 2; });
+  ASSERT_EQ(halves[3].asRight(), 1.5f);
+  ASSERT_EQ(halves[10].asLeft(), -10);
+  auto even = column.filterOrElse([](float f) { return int(f) % 2 == 0; }, 1);
+  ASSERT_EQ(even[3].asLeft(), 1);
+  ASSERT_EQ(even[4].asRight(), 4.f);
+  ASSERT_EQ(column.getOrElse(0)[5], 0.f);
+  std::remove(path.c_str());
+}
+
+TEST(Column, errors) {
+  ASSERT_TRUE(ma::openMaybeColumn<int>(columnPath("missing")).isLeft());
+
+  const std::vector<Maybe<double>> rows = {Maybe<double>(1.0)};
+  const auto path = columnPath("mismatch");
+  ASSERT_TRUE(ma::writeColumn(path, rows.begin(), rows.end()).isRight());
+  auto wrongType = ma::openMaybeColumn<float>(path);
+  ASSERT_TRUE(wrongType.isLeft());
+  ASSERT_NE(wrongType.asLeft().find("type mismatch"), std::string::npos);
+  ASSERT_TRUE((ma::openEitherColumn<int, double>(path).isLeft()));
+  std::remove(path.c_str());
+}
+
+TEST(Column, corruptRowCount) {
+  const std::vector<Maybe<double>> rows = {Maybe<double>(1.0), Nothing};
+  const auto path = columnPath("rows");
+  ASSERT_TRUE(ma::writeColumn(path, rows.begin(), rows.end()).isRight());
+  /* a row count for which the section sizes wrap around to 0 */
+  const std::uint64_t huge = UINT64_MAX - 2;
+  std::FILE* f = std::fopen(path.c_str(), "r+b");
+  ASSERT_NE(f, nullptr);
+  std::fseek(f, offsetof(ma::detail::ColumnHeader, rows), SEEK_SET);
+  std::fwrite(&huge, sizeof(huge), 1, f);
+  std::fclose(f);
+  auto column = ma::openMaybeColumn<double>(path);
+  ASSERT_TRUE(column.isLeft());
+  ASSERT_NE(column.asLeft().find("truncated"), std::string::npos);
+  std::remove(path.c_str());
+}
+
+TEST(Column, corruptRankDirectory) {
+  std::vector<Maybe<int>> rows;
+  for (int i = 0; i < 2000; ++i) {
+    rows.push_back(i % 3 ? Maybe<int>(i) : Nothing);
+  }
+  const auto path = columnPath("ranks");
+  ma::detail::ColumnHeader header;
+  auto patch = [&](std::size_t entry, std::uint64_t value) {
+    ASSERT_TRUE(ma::writeColumn(path, rows.begin(), rows.end()).isRight());
+    std::FILE* f = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(f, nullptr);
+    ASSERT_EQ(std::fread(&header, sizeof(header), 1, f), 1u);
+    std::fseek(f, static_cast<long>(header.ranks + 8 * entry), SEEK_SET);
+    std::fwrite(&value, sizeof(value), 1, f);
+    std::fclose(f);
+  };
+  auto rejected = [&] {
+    auto column = ma::openMaybeColumn<int>(path);
+    return column.isLeft() &&
+           column.asLeft().find("corrupt rank directory") != std::string::npos;
+  };
+  /* an entry above the following one */
+  patch(2, 1300);
+  ASSERT_TRUE(rejected());
+  /* a block claiming more set bits than it holds */
+  patch(1, 0);
+  ASSERT_TRUE(rejected());
+  /* a directory not starting at 0 */
+  patch(0, 1);
+  ASSERT_TRUE(rejected());
+  std::remove(path.c_str());
+}
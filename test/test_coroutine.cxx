@@ -0,0 +1,141 @@
+#include "marjoram/coroutine.hpp"
+#include "gtest/gtest.h"
+
+#ifdef MARJORAM_HAS_COROUTINES
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+using ma::Either;
+using ma::Just;
+using ma::Lazy;
+using ma::Left;
+using ma::Maybe;
+using ma::Nothing;
+using ma::Right;
+
+namespace {
+Maybe<int> parse(const std::string& s) {
+  if (s.empty() || s.find_first_not_of("0123456789") != std::string::npos) {
+    return Nothing;
+  }
+  return std::stoi(s);
+}
+
+Maybe<double> ratio(const std::string& a, const std::string& b) {
+  int x = co_await parse(a);
+  int y = co_await parse(b);
+  if (y == 0) {
+    co_return Nothing;
+  }
+  co_return static_cast<double>(x) / y;
+}
+
+int steps = 0;
+
+Maybe<int> throwsAfter(Maybe<int> a) {
+  int x = co_await a;
+  throw std::runtime_error(std::to_string(x));
+}
+
+Maybe<int> countSteps(Maybe<int> a, Maybe<int> b) {
+  steps = 0;
+  int x = co_await a;
+  steps++;
+  int y = co_await std::move(b);
+  steps++;
+  co_return x + y;
+}
+}  // namespace
+
+TEST(Coroutine, maybe) {
+  ASSERT_EQ(ratio("6", "4"), Just(1.5));
+  ASSERT_EQ(ratio("six", "4"), Nothing);
+  ASSERT_EQ(ratio("6", ""), Nothing);
+  ASSERT_EQ(ratio("6", "0"), Nothing);
+
+  ASSERT_EQ(countSteps(1, 2), Just(3));
+  ASSERT_EQ(steps, 2);
+  ASSERT_EQ(countSteps(1, Nothing), Nothing);
+  ASSERT_EQ(steps, 1);
+  ASSERT_EQ(countSteps(Nothing, 2), Nothing);
+  ASSERT_EQ(steps, 0);
+}
+
+namespace {
+Either<std::string, int> checked(int i) {
+  if (i < 0) {
+    return Either<std::string, int>(Left, "negative");
+  }
+  return i;
+}
+
+Either<std::string, std::unique_ptr<int>> sum(int a, int b) {
+  int x = co_await checked(a);
+  int y = co_await checked(b);
+  co_return std::make_unique<int>(x + y);
+}
+
+Either<std::string, int> throws() {
+  co_await checked(1);
+  throw std::runtime_error("oops");
+}
+}  // namespace
+
+TEST(Coroutine, either) {
+  auto three = sum(1, 2);
+  ASSERT_TRUE(three.isRight());
+  ASSERT_EQ(*three.asRight(), 3);
+
+  auto negative = sum(1, -2);
+  ASSERT_TRUE(negative.isLeft());
+  ASSERT_EQ(negative.asLeft(), "negative");
+
+  ASSERT_THROW(throws(), std::runtime_error);
+}
+
+namespace {
+Lazy<int> twice(const Lazy<int>& la, int& evalCount) {
+  evalCount++;
+  const int& i = co_await la;
+  co_return 2 * i;
+}
+}  // namespace
+
+TEST(Coroutine, lazy) {
+  int evalCount = 0;
+  Lazy<int> five([]() { return 5; });
+  Lazy<int> ten = twice(five, evalCount);
+  ASSERT_EQ(evalCount, 0);
+  ASSERT_FALSE(five.isEvaluated());
+
+  ASSERT_EQ(ten.get(), 10);
+  ASSERT_EQ(evalCount, 1);
+  ASSERT_TRUE(five.isEvaluated());
+  ASSERT_EQ(ten.get(), 10);
+  ASSERT_EQ(evalCount, 1);
+
+  /* never evaluated, frame is released */
+  Lazy<int> unused = twice(five, evalCount);
+  ASSERT_EQ(evalCount, 1);
+}
+
+TEST(Coroutine, frameRecycling) {
+  /* frames of identical coroutines are recycled */
+  const std::size_t before = ma::detail::FramePool::hits();
+  for (int i = 0; i < 1000; ++i) {
+    ASSERT_EQ(ratio(std::to_string(i), "1"), Just(static_cast<double>(i)));
+  }
+  ASSERT_GE(ma::detail::FramePool::hits() - before, 999u);
+}
+
+TEST(Coroutine, exceptionReleasesFrame) {
+  ASSERT_EQ(throwsAfter(Nothing), Nothing);
+  /* the frame of a throwing coroutine is recycled as well */
+  const std::size_t before = ma::detail::FramePool::hits();
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_THROW(throwsAfter(i), std::runtime_error);
+  }
+  ASSERT_GE(ma::detail::FramePool::hits() - before, 100u);
+}
+#endif
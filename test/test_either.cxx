@@ -1,6 +1,9 @@
 #include "marjoram/either.hpp"
 #include "gtest/gtest.h"
+#include <algorithm>
 #include <string>
+#include <unordered_set>
+#include <vector>
 
 using ma::Either;
 using ma::Left;
@@ -409,3 +412,153 @@ TEST(Either, leftFlatMap_move) {
   ma::Either<std::string, std::string> expected{ma::Left, "4"};
   ASSERT_EQ(eight, expected);
 }
+
+TEST(Either, reference) {
+  std::string found = "found";
+  ma::Either<int, std::string&> ref(Right, found);
+  ASSERT_EQ(&ref.asRight(), &found);
+
+  ma::Either<int, std::string&> copy = ref;
+  copy.asRight() += "!";
+  ASSERT_EQ(found, "found!");
+
+  auto size = std::move(copy).map([](std::string& s) { return s.size(); });
+  ASSERT_EQ(size.asRight(), 6u);
+  ASSERT_EQ(found, "found!");
+  ASSERT_EQ(&ref.toMaybe().get(), &found);
+
+  ma::Either<int, const std::string&> error(Left, 404);
+  ASSERT_EQ(error.getOrElse(found), "found!");
+  ASSERT_EQ(error.flatMap([](const std::string& s) {
+                   return ma::Either<int, std::size_t>(Right, s.size());
+                 })
+                .asLeft(),
+            404);
+  ASSERT_EQ(ref, (ma::Either<int, std::string&>(Right, found)));
+  for (std::string& s : ref) {
+    ASSERT_EQ(&s, &found);
+  }
+}
+
+TEST(Either, rightStatic) {
+  ma::Right_t<std::string, int> four(Right, 4);
+  static_assert(decltype(four)::isRight(), "Right_t is statically right");
+  ASSERT_EQ(four.asRight(), 4);
+  ASSERT_EQ(four.getOrElse(0), 4);
+
+  auto half = four.map([](int i) { return i / 2.0; });
+  static_assert(
+      std::is_same<decltype(half), ma::Right_t<std::string, double>>::value,
+      "map keeps the side");
+  ASSERT_EQ(half.asRight(), 2.0);
+  ASSERT_EQ(four.toMaybe().get(), 4);
+
+  Either<std::string, int> either = four;
+  ASSERT_EQ(either, four);
+  ASSERT_NE((Either<std::string, int>(Left, "four")), four);
+  ASSERT_EQ(four.fold([](const std::string&) { return 0; },
+                      [](int i) { return i + 1; }),
+            5);
+}
+
+TEST(Either, ifRight) {
+  Either<int, std::string> text(Right, "text");
+  ASSERT_TRUE(text.ifRight(
+      [](ma::Right_t<int, std::string&> s) { s.asRight() += "!"; }));
+  ASSERT_EQ(text.asRight(), "text!");
+
+  std::string taken;
+  ASSERT_TRUE(std::move(text).ifRight(
+      [&taken](ma::Right_t<int, std::string> s) {
+        taken = std::move(s.asRight());
+      }));
+  ASSERT_EQ(taken, "text!");
+
+  const Either<int, std::string> error(Left, 404);
+  ASSERT_FALSE(
+      error.ifRight([](ma::Right_t<int, const std::string&>) { FAIL(); }));
+}
+
+TEST(Either, never) {
+  using ma::Never;
+  static_assert(sizeof(Either<Never, double>) == sizeof(double),
+                "Either<Never, B> stores no tag");
+  static_assert(sizeof(Either<std::string, Never>) == sizeof(std::string),
+                "Either<A, Never> stores no tag");
+
+  Either<Never, int> infallible(Right, 4);
+  ASSERT_TRUE(infallible.isRight());
+  ASSERT_EQ(infallible.fold([](const auto&) { return 0; },
+                            [](int i) { return i + 1; }),
+            5);
+  auto doubled = infallible.map([](int i) { return 2 * i; });
+  static_assert(std::is_same<decltype(doubled), Either<Never, int>>::value,
+                "map keeps Never");
+  ASSERT_EQ(doubled.asRight(), 8);
+
+  auto checked = infallible.flatMap([](int i) {
+    return i > 3 ? Either<std::string, int>(Right, i)
+                 : Either<std::string, int>(Left, "too small");
+  });
+  static_assert(
+      std::is_same<decltype(checked), Either<std::string, int>>::value,
+      "flatMap widens the left type");
+  ASSERT_EQ(checked.asRight(), 4);
+
+  /* an infallible step after a fallible one keeps the left type */
+  auto incremented = checked.flatMap(
+      [](int i) { return Either<Never, int>(Right, i + 1); });
+  static_assert(
+      std::is_same<decltype(incremented), Either<std::string, int>>::value,
+      "flatMap into Either<Never, C> keeps the left type");
+  ASSERT_EQ(incremented.asRight(), 5);
+  Either<std::string, int> tooSmall(Left, "too small");
+  auto skipped = std::move(tooSmall).flatMap(
+      [](int i) { return Either<Never, int>(Right, i + 1); });
+  ASSERT_EQ(skipped.asLeft(), "too small");
+
+  std::unordered_set<Either<Never, int>> set{infallible, doubled};
+  ASSERT_EQ(set.size(), 2u);
+  ASSERT_EQ(set.count(Either<Never, int>(Right, 8)), 1u);
+
+  Either<std::string, int> widened = infallible;
+  ASSERT_EQ(widened.asRight(), 4);
+  ASSERT_EQ(infallible, (Either<Never, int>(Right, 4)));
+  ASSERT_EQ(infallible.mirror().asLeft(), 4);
+
+  Either<std::string, Never> failed(Left, "failed");
+  ASSERT_TRUE(failed.isLeft());
+  auto copy = Either<std::string, Never>(Left, "copy");
+  copy = failed;
+  Either<std::string, int> failure = std::move(failed);
+  ASSERT_EQ(failure.asLeft(), "failed");
+  ASSERT_EQ(copy.leftMap([](const std::string& s) { return s.size(); })
+                .asLeft(),
+            6u);
+
+  std::string found = "found";
+  Either<Never, std::string&> ref(Right, found);
+  ASSERT_EQ(&ref.asRight(), &found);
+}
+
+TEST(Either, ordering) {
+  using E = Either<std::string, int>;
+  std::vector<E> values{E(Right, 2), E(Left, "b"), E(Right, 1), E(Left, "a")};
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(values,
+            (std::vector<E>{E(Left, "a"), E(Left, "b"), E(Right, 1),
+                            E(Right, 2)}));
+  ASSERT_LT(E(Left, "z"), E(Right, 0));
+  ASSERT_GT(E(Right, 0), E(Left, "z"));
+  ASSERT_LE(E(Right, 0), E(Right, 0));
+  ASSERT_GE(E(Left, "b"), E(Left, "a"));
+}
+
+TEST(Either, hash) {
+  using E = Either<int, int>;
+  std::unordered_set<E> set{E(Left, 1), E(Right, 1), E(Left, 1)};
+  ASSERT_EQ(set.size(), 2u);
+  ASSERT_EQ(set.count(E(Right, 1)), 1u);
+  ASSERT_EQ(set.count(E(Right, 2)), 0u);
+  ASSERT_NE(std::hash<E>()(E(Left, 1)), std::hash<E>()(E(Right, 1)));
+}
@@ -0,0 +1,158 @@
+#include "marjoram/fetch.hpp"
+#include "gtest/gtest.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using ma::Fetch;
+using ma::FetchRun;
+using ma::Maybe;
+using ma::Reader;
+
+namespace {
+struct User {
+  std::string name;
+  int supervisorId;
+};
+
+/* in-process source counting its calls */
+template <typename K, typename V> struct FakeSource {
+  using key_type = K;
+  using value_type = Maybe<V>;
+
+  std::vector<Maybe<V>> multiGet(const std::vector<K>& keys) const {
+    calls++;
+    requested += keys.size();
+    std::vector<Maybe<V>> values;
+    for (const auto& k : keys) {
+      auto it = data.find(k);
+      if (it == data.end()) {
+        values.push_back(ma::Nothing);
+      } else {
+        values.push_back(it->second);
+      }
+    }
+    return values;
+  }
+
+  std::map<K, V> data;
+  mutable int calls = 0;
+  mutable std::size_t requested = 0;
+};
+
+struct Repository {
+  FakeSource<int, User> users;
+  FakeSource<std::string, int> logins;
+};
+
+using RepositoryRef = std::reference_wrapper<const Repository>;
+
+Repository repository() {
+  Repository r;
+  for (int i = 0; i < 300; ++i) {
+    r.users.data[i] = User{"user" + std::to_string(i), i / 10};
+  }
+  r.logins.data["root"] = 0;
+  r.logins.data["alice"] = 42;
+  return r;
+}
+
+Reader<RepositoryRef, Fetch<Maybe<User>>> getUser(int id) {
+  return Reader<RepositoryRef, Fetch<Maybe<User>>>(
+      [id](const RepositoryRef& r) { return ma::fetch(r.get().users, id); });
+}
+
+Reader<RepositoryRef, Fetch<std::string>> name(int id) {
+  return getUser(id).map([](Fetch<Maybe<User>> user) {
+    return user.map([](const Maybe<User>& u) {
+      return u.map([](const User& v) { return v.name; }).getOrElse("?");
+    });
+  });
+}
+
+Reader<RepositoryRef, Fetch<std::vector<std::string>>> names(
+    std::vector<int> ids) {
+  return Reader<RepositoryRef, Fetch<std::vector<std::string>>>(
+      [ids](const RepositoryRef& r) {
+        return ma::traverse(ids, [&r](int id) { return name(id).run(r); });
+      });
+}
+
+/* depends on the user, hence needs a second round */
+Reader<RepositoryRef, Fetch<std::string>> supervisorName(int id) {
+  return Reader<RepositoryRef, Fetch<std::string>>(
+      [id](const RepositoryRef& r) {
+        return getUser(id).run(r).flatMap([r](const Maybe<User>& u) {
+          return name(u.isJust() ? u.get().supervisorId : -1).run(r);
+        });
+      });
+}
+}  // namespace
+
+TEST(Fetch, batchesIndependentRequests) {
+  const Repository repo = repository();
+  std::vector<int> ids;
+  for (int i = 0; i < 200; ++i) {
+    ids.push_back(i);
+  }
+  auto all = ma::runFetch(names(ids)).run(std::cref(repo));
+  ASSERT_EQ(all.size(), 200u);
+  ASSERT_EQ(all[0], "user0");
+  ASSERT_EQ(all[199], "user199");
+  ASSERT_EQ(repo.users.calls, 1);
+  ASSERT_EQ(repo.users.requested, 200u);
+}
+
+TEST(Fetch, deduplicates) {
+  const Repository repo = repository();
+  auto all = ma::runFetch(names({3, 1, 3, 3, 1, 500})).run(std::cref(repo));
+  ASSERT_EQ(all, (std::vector<std::string>{"user3", "user1", "user3", "user3",
+                                           "user1", "?"}));
+  ASSERT_EQ(repo.users.calls, 1);
+  ASSERT_EQ(repo.users.requested, 3u);
+}
+
+TEST(Fetch, dependentRequestsTakeRounds) {
+  const Repository repo = repository();
+  std::vector<Fetch<std::string>> supervisors;
+  for (int i = 10; i < 60; ++i) {
+    supervisors.push_back(supervisorName(i).run(std::cref(repo)));
+  }
+  FetchRun run;
+  auto all = run.run(ma::sequence(supervisors));
+  ASSERT_EQ(all[0], "user1");
+  ASSERT_EQ(all[49], "user5");
+  ASSERT_EQ(run.rounds(), 2u);
+  ASSERT_EQ(repo.users.calls, 2);
+  /* the 50 users, then their 5 distinct supervisors */
+  ASSERT_EQ(repo.users.requested, 55u);
+}
+
+TEST(Fetch, zipAcrossSources) {
+  const Repository repo = repository();
+  auto both = ma::zip(ma::fetch(repo.logins, std::string("alice")),
+                      ma::fetch(repo.users, 7), ma::fetch(repo.users, 8),
+                      Fetch<int>::pure(5));
+  FetchRun run;
+  auto r = run.run(both);
+  ASSERT_EQ(std::get<0>(r).get(), 42);
+  ASSERT_EQ(std::get<1>(r).get().name, "user7");
+  ASSERT_EQ(std::get<2>(r).get().name, "user8");
+  ASSERT_EQ(std::get<3>(r), 5);
+  ASSERT_EQ(run.rounds(), 1u);
+  ASSERT_EQ(repo.logins.calls, 1);
+  ASSERT_EQ(repo.users.calls, 1);
+}
+
+TEST(Fetch, cachePerRun) {
+  const Repository repo = repository();
+  FetchRun run;
+  ASSERT_EQ(run.run(name(5).run(std::cref(repo))), "user5");
+  ASSERT_EQ(run.run(name(5).run(std::cref(repo))), "user5");
+  ASSERT_EQ(repo.users.calls, 1);
+
+  ASSERT_EQ(ma::runFetch(name(5).run(std::cref(repo))), "user5");
+  ASSERT_EQ(repo.users.calls, 2);
+}
@@ -0,0 +1,110 @@
+#include "marjoram/binary.hpp"
+#include "marjoram/flat.hpp"
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+using ma::FlatEither;
+using ma::FlatMaybe;
+using ma::Left;
+using ma::Maybe;
+using ma::Right;
+
+namespace {
+struct Quote {
+  std::int64_t price;
+  std::int32_t size;
+};
+
+bool operator==(const Quote& lhs, const Quote& rhs) {
+  return lhs.price == rhs.price && lhs.size == rhs.size;
+}
+
+/* segment holding values and references to them */
+struct Segment {
+  int values[4];
+  FlatMaybe<int&> chosen;
+};
+}  // namespace
+
+TEST(Flat, layout) {
+  static_assert(std::is_standard_layout<FlatMaybe<Quote>>::value, "");
+  static_assert(std::is_trivially_copyable<FlatMaybe<Quote>>::value, "");
+  static_assert(std::is_standard_layout<FlatEither<int, Quote>>::value, "");
+  static_assert(std::is_trivially_copyable<FlatEither<int, Quote>>::value,
+                "");
+  static_assert(std::is_standard_layout<FlatMaybe<int&>>::value, "");
+  static_assert(std::is_standard_layout<ma::OffsetPtr<Quote>>::value, "");
+  static_assert(sizeof(FlatMaybe<const Quote&>) == sizeof(std::ptrdiff_t),
+                "offset only");
+  static_assert(sizeof(FlatMaybe<double>) == 16, "tag padded to 8");
+  static_assert(sizeof(FlatEither<char, Quote>) ==
+                    ma::Encoding<ma::Either<char, Quote>>::size,
+                "layout of the binary encoding");
+
+  FlatMaybe<double> half(0.5);
+  unsigned char bytes[sizeof(half)];
+  std::memcpy(bytes, &half, sizeof(half));
+  ASSERT_EQ(bytes[0], 1);
+  double value;
+  std::memcpy(&value, bytes + alignof(double), sizeof(value));
+  ASSERT_EQ(value, 0.5);
+
+  FlatMaybe<double> none;
+  std::memcpy(bytes, &none, sizeof(none));
+  for (unsigned char b : bytes) {
+    ASSERT_EQ(b, 0);
+  }
+
+  FlatEither<char, std::int64_t> price(Right, 5);
+  unsigned char encoded[sizeof(price)];
+  ma::encode(price.toEither(), encoded);
+  ASSERT_EQ(std::memcmp(encoded, &price, sizeof(price)), 0);
+}
+
+TEST(Flat, maybe) {
+  FlatMaybe<Quote> quote(Quote{100, 3});
+  ASSERT_TRUE(quote.isJust());
+  ASSERT_EQ(quote.get().size, 3);
+  ASSERT_EQ(quote.toMaybe(), Maybe<Quote>(Quote{100, 3}));
+  ASSERT_EQ(FlatMaybe<Quote>(quote.toMaybe()), quote);
+  ASSERT_TRUE(FlatMaybe<Quote>(Maybe<Quote>()).isNothing());
+  ASSERT_EQ(FlatMaybe<int>(ma::Nothing).getOrElse(4), 4);
+  ASSERT_NE(FlatMaybe<int>(), FlatMaybe<int>(0));
+}
+
+TEST(Flat, either) {
+  FlatEither<int, Quote> error(Left, 404);
+  ASSERT_TRUE(error.isLeft());
+  ASSERT_EQ(error.asLeft(), 404);
+  ASSERT_EQ(error.toEither().asLeft(), 404);
+
+  FlatEither<int, Quote> quote(ma::Either<int, Quote>(Right, Quote{7, 1}));
+  ASSERT_EQ(quote.asRight().price, 7);
+  ASSERT_NE(quote, error);
+  ASSERT_EQ(quote, (FlatEither<int, Quote>(Right, Quote{7, 1})));
+}
+
+TEST(Flat, offsetReference) {
+  alignas(Segment) unsigned char first[sizeof(Segment)];
+  auto* segment = new (first) Segment{{1, 2, 3, 4}, {}};
+  ASSERT_TRUE(segment->chosen.isNothing());
+  segment->chosen = FlatMaybe<int&>(segment->values[2]);
+  ASSERT_EQ(segment->chosen.get(), 3);
+
+  /* the same segment, mapped elsewhere */
+  alignas(Segment) unsigned char second[sizeof(Segment)];
+  std::memcpy(second, first, sizeof(first));
+  auto* moved = reinterpret_cast<Segment*>(second);
+  ASSERT_EQ(&moved->chosen.get(), &moved->values[2]);
+  moved->chosen.get() = 5;
+  ASSERT_EQ(segment->values[2], 3);
+  ASSERT_EQ(moved->chosen.toMaybe().get(), 5);
+
+  int outside = 9;
+  ASSERT_EQ(segment->chosen.getOrElse(outside), 3);
+  ASSERT_EQ(FlatMaybe<int&>().getOrElse(outside), 9);
+}
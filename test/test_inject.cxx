@@ -0,0 +1,126 @@
+#include "marjoram/inject.hpp"
+#include "gtest/gtest.h"
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+using ma::Injector;
+using ma::Reader;
+using ma::RequestScoped;
+using ma::Singleton;
+
+namespace {
+struct User {
+  std::string name;
+  std::string email;
+  int supervisorId;
+};
+
+/* no virtual calls, and neither copyable nor movable */
+class UserRepository {
+ public:
+  UserRepository() {
+    users_[0] = User{"John Doe", "john.doe@acme.corp", 0};
+    users_[1] = User{"Jane Roe", "jane.roe@acme.corp", 0};
+  }
+  UserRepository(const UserRepository&) = delete;
+
+  const User& get(int id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    lookups_++;
+    return users_.at(id);
+  }
+
+  int lookups() const { return lookups_; }
+
+ private:
+  std::map<int, User> users_;
+  mutable std::mutex mutex_;
+  mutable int lookups_ = 0;
+};
+
+struct Greeting {
+  std::string text = "Hello";
+};
+
+struct RequestId {
+  int value = -1;
+};
+
+using App = Injector<Singleton<UserRepository>, Singleton<Greeting>,
+                     RequestScoped<RequestId>>;
+
+auto getUser(int id) {
+  return ma::ask<UserRepository>().map(
+      [id](const UserRepository& users) -> const User& {
+        return users.get(id);
+      });
+}
+
+auto greet(int id) {
+  return getUser(id).flatMap([](const User& user) {
+    return ma::ask<Greeting>().map([&user](const Greeting& g) {
+      return g.text + " " + user.name;
+    });
+  });
+}
+
+auto requestId() {
+  return ma::ask<RequestId>().map([](const RequestId& r) { return r.value; });
+}
+}  // namespace
+
+TEST(Inject, resolvesComponents) {
+  App app;
+  auto context = app.request(RequestId{42});
+  ASSERT_EQ(&context.get<UserRepository>(), &app.get<UserRepository>());
+  ASSERT_EQ(greet(1).run(context), "Hello Jane Roe");
+  ASSERT_EQ(requestId().run(context), 42);
+  ASSERT_EQ(app.get<UserRepository>().lookups(), 1);
+}
+
+TEST(Inject, componentsAreNotCopied) {
+  App app;
+  auto context = app.request();
+  const User& john = getUser(0).run(context);
+  ASSERT_EQ(&john, &app.get<UserRepository>().get(0));
+  /* composition does not erase types, unlike std::function */
+  static_assert(std::is_trivially_copyable<decltype(greet(0))>::value, "");
+  static_assert(std::is_same<decltype(getUser(0).run(context)),
+                             const User&>::value,
+                "");
+}
+
+TEST(Inject, lifetimes) {
+  App app(Greeting{"Hi"});
+  auto first = app.request(RequestId{1});
+  auto second = app.request(RequestId{2});
+  ASSERT_EQ(requestId().run(first), 1);
+  ASSERT_EQ(requestId().run(second), 2);
+  ASSERT_EQ(requestId().run(app.request()), -1);
+
+  app.get<Greeting>().text = "Hey";
+  ASSERT_EQ(greet(0).run(first), "Hey John Doe");
+  ASSERT_EQ(greet(0).run(second), "Hey John Doe");
+}
+
+TEST(Inject, interoperatesWithReader) {
+  using Context = decltype(std::declval<App&>().request());
+  using ContextRef = std::reference_wrapper<const Context>;
+
+  App app;
+  auto context = app.request(RequestId{7});
+  Reader<ContextRef, std::string> email =
+      getUser(0)
+          .map([](const User& u) { return u.email; })
+          .toReader<ContextRef>();
+  ASSERT_EQ(email.run(std::cref(context)), "john.doe@acme.corp");
+
+  auto tagged = ma::asks([](const ContextRef& c) {
+    return c.get().get<RequestId>().value;
+  });
+  ASSERT_EQ(tagged.run(std::cref(context)), 7);
+  ASSERT_EQ(requestId().run(std::cref(context)), 7);
+}
@@ -0,0 +1,97 @@
+#include "marjoram/either.hpp"
+#include "marjoram/interop.hpp"
+#include "marjoram/maybe.hpp"
+#include "gtest/gtest.h"
+#include <memory>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+using ma::Either;
+using ma::Left;
+using ma::Maybe;
+using ma::Right;
+
+TEST(Interop, optional) {
+  Maybe<std::string> text = std::optional<std::string>("text");
+  ASSERT_EQ(text.get(), "text");
+  Maybe<std::string> none = std::optional<std::string>();
+  ASSERT_TRUE(none.isNothing());
+  ASSERT_EQ(text.toOptional(), std::optional<std::string>("text"));
+  ASSERT_FALSE(none.toOptional().has_value());
+
+  std::optional<std::unique_ptr<int>> owned = std::make_unique<int>(3);
+  Maybe<std::unique_ptr<int>> moved = std::move(owned);
+  ASSERT_EQ(*moved.get(), 3);
+  std::optional<std::unique_ptr<int>> back = std::move(moved).toOptional();
+  ASSERT_EQ(**back, 3);
+
+  Maybe<std::unique_ptr<int>&> ref = back;
+  ASSERT_EQ(&ref.get(), &*back);
+}
+
+TEST(Interop, variant) {
+  Either<int, std::string> text = std::variant<int, std::string>("text");
+  ASSERT_EQ(text.asRight(), "text");
+  Either<int, std::string> number = std::variant<int, std::string>(4);
+  ASSERT_EQ(number.asLeft(), 4);
+  ASSERT_EQ(std::get<1>(text.toVariant()), "text");
+  ASSERT_EQ(number.toVariant().index(), 0u);
+
+  std::variant<int, std::unique_ptr<int>> owned = std::make_unique<int>(5);
+  Either<int, std::unique_ptr<int>> moved = std::move(owned);
+  ASSERT_EQ(*moved.asRight(), 5);
+  auto back = std::move(moved).toVariant();
+  ASSERT_EQ(*std::get<1>(back), 5);
+}
+
+TEST(Interop, view) {
+  std::vector<std::optional<int>> values = {1, std::nullopt, 3};
+  auto view = ma::asMaybes(values);
+  ASSERT_EQ(view.size(), 3u);
+  ASSERT_EQ(&view[0].get(), &*values[0]);
+  ASSERT_TRUE(view[1].isNothing());
+
+  for (Maybe<int&> m : view) {
+    for (int& i : m) {
+      i *= 10;
+    }
+  }
+  ASSERT_EQ(*values[2], 30);
+
+  const auto& constValues = values;
+  int sum = 0;
+  for (Maybe<const int&> m : ma::asMaybes(constValues)) {
+    sum += m.getOrElse(0);
+  }
+  ASSERT_EQ(sum, 40);
+}
+
+#ifdef MARJORAM_HAS_STD_EXPECTED
+TEST(Interop, expected) {
+  Either<std::string, int> four = std::expected<int, std::string>(4);
+  ASSERT_EQ(four.asRight(), 4);
+  Either<std::string, int> error =
+      std::expected<int, std::string>(std::unexpect, "error");
+  ASSERT_EQ(error.asLeft(), "error");
+  ASSERT_EQ(four.toExpected().value(), 4);
+  ASSERT_EQ(std::move(error).toExpected().error(), "error");
+}
+#endif
+
+#ifdef MARJORAM_HAS_THREE_WAY_COMPARISON
+TEST(Interop, threeWayComparison) {
+  ASSERT_TRUE((Maybe<int>() <=> Maybe<int>(1)) < 0);
+  ASSERT_TRUE((Maybe<int>(2) <=> Maybe<int>(1)) > 0);
+  ASSERT_TRUE((Maybe<int>() <=> Maybe<int>()) == 0);
+  static_assert(std::is_same<decltype(Maybe<double>() <=> Maybe<double>()),
+                             std::partial_ordering>::value,
+                "Maybe<double> is partially ordered");
+
+  using E = Either<std::string, int>;
+  ASSERT_TRUE((E(Left, "z") <=> E(Right, 0)) < 0);
+  ASSERT_TRUE((E(Right, 1) <=> E(Right, 1)) == 0);
+  ASSERT_TRUE((E(Left, "b") <=> E(Left, "a")) > 0);
+}
+#endif
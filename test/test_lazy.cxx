@@ -115,3 +115,15 @@ TEST(Lazy, For) {
   }
   ASSERT_TRUE(ten.isEvaluated());
 }
+
+TEST(Lazy, labeled) {
+  Lazy<int> five([]() { return 5; }, MARJORAM_LAZY_LABEL("five"));
+  Lazy<int> ten =
+      five.map([](int i) { return 2 * i; }).labeled(MARJORAM_LAZY_LABEL("ten"));
+  ASSERT_EQ(ten.get(), 10);
+#ifndef MARJORAM_PROFILE_LAZY
+  /* labels are free when not profiling */
+  static_assert(
+      sizeof(Lazy<int>) == sizeof(ma::Either<std::function<int()>, int>), "");
+#endif
+}
@@ -0,0 +1,57 @@
+#include "marjoram/lazyPool.hpp"
+#include "gtest/gtest.h"
+#include <string>
+#include <tuple>
+
+using ma::Lazy;
+using ma::LazyPool;
+
+TEST(LazyPool, sharesNodes) {
+  int evalCount = 0;
+  auto square = [&evalCount](int i) {
+    return [&evalCount, i]() {
+      evalCount++;
+      return i * i;
+    };
+  };
+  LazyPool<std::tuple<std::string, int>, int> pool;
+
+  auto a = pool.intern(std::make_tuple("square", 5), square(5));
+  auto b = pool.intern(std::make_tuple("square", 5), square(5));
+  auto c = pool.intern(std::make_tuple("square", 6), square(6));
+  ASSERT_EQ(a, b);
+  ASSERT_NE(a, c);
+
+  ASSERT_EQ(a->get(), 25);
+  ASSERT_EQ(b->get(), 25);
+  ASSERT_EQ(evalCount, 1);
+  ASSERT_TRUE(b->isEvaluated());
+  ASSERT_FALSE(c->isEvaluated());
+}
+
+TEST(LazyPool, weakReferences) {
+  int evalCount = 0;
+  auto count = [&evalCount]() { return ++evalCount; };
+  LazyPool<int, int> pool;
+
+  auto one = pool.intern(1, count);
+  ASSERT_EQ(one->get(), 1);
+  ASSERT_TRUE(pool.find(1).isJust());
+
+  /* once released, the computation is done anew */
+  one.reset();
+  ASSERT_TRUE(pool.find(1).isNothing());
+  ASSERT_EQ(pool.intern(1, count)->get(), 2);
+
+  pool.purge();
+  ASSERT_EQ(pool.size(), 0u);
+}
+
+TEST(LazyPool, boundedGrowth) {
+  LazyPool<int, int> pool;
+  for (int i = 0; i < 1000; ++i) {
+    /* nodes are released immediately */
+    ASSERT_EQ(pool.intern(i, [i]() { return i; })->get(), i);
+  }
+  ASSERT_LE(pool.size(), 16u);
+}
@@ -1,11 +1,18 @@
 #include "marjoram/maybe.hpp"
 #include "marjoram/nothing.hpp"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 using ma::Just;
 using ma::Maybe;
 using ma::Nothing;
+using ma::Present;
 
 TEST(Maybe, flatMap) {
   auto five = Just(5);
@@ -517,3 +524,152 @@ TEST(Maybe, reset) {
   mbPinned.reset();
   ASSERT_TRUE(mbPinned.isNothing());
 }
+
+TEST(Maybe, reference) {
+  int five = 5;
+  Maybe<int&> ref(five);
+  static_assert(sizeof(ref) == sizeof(int*), "");
+  ASSERT_TRUE(ref.isJust());
+  ASSERT_EQ(&ref.get(), &five);
+
+  ASSERT_EQ(ref.map([](int& i) { return ++i; }).get(), 6);
+  ASSERT_EQ(five, 6);
+  Maybe<const int&> constRef = ref;
+  ASSERT_TRUE(constRef.contains(6));
+
+  int other = 0;
+  ASSERT_EQ(&Maybe<int&>().getOrElse(other), &other);
+  ASSERT_EQ(Maybe<const int&>().getOrElse(3), 3);
+  ASSERT_EQ(&Maybe<int&>(other)
+                 .map([&five](int&) -> int& { return five; })
+                 .filter([](int i) { return i == 6; })
+                 .get(),
+            &five);
+  ASSERT_EQ(ref, Maybe<int&>(five));
+
+  auto sum = 0;
+  for (int& i : ref) {
+    sum += i;
+  }
+  ASSERT_EQ(sum, 6);
+  for (int& i : Maybe<int&>()) {
+    sum += i;
+  }
+  ASSERT_EQ(sum, 6);
+}
+
+TEST(Maybe, lookup) {
+  std::map<std::string, std::unique_ptr<int>, std::less<>> cache;
+  cache.emplace("a", std::make_unique<int>(1));
+
+  Maybe<std::unique_ptr<int>&> a = ma::lookup(cache, "a");
+  ASSERT_TRUE(a.isJust());
+  ASSERT_EQ(&a.get(), &cache["a"]);
+  ASSERT_TRUE(ma::lookup(cache, "b").isNothing());
+
+  const auto& constCache = cache;
+  Maybe<const std::unique_ptr<int>&> constA = ma::lookup(constCache, "a");
+  ASSERT_EQ(constA.map([](const std::unique_ptr<int>& p) { return *p; }),
+            Just(1));
+  auto missing = ma::lookup(constCache, "b").toRight(std::string("missing"));
+  ASSERT_EQ(missing.asLeft(), "missing");
+}
+
+TEST(Maybe, present) {
+  auto five = Present(5);
+  static_assert(decltype(five)::isJust(), "Just_t is statically present");
+  ASSERT_EQ(five.get(), 5);
+  ASSERT_EQ(five.getOrElse(0), 5);
+
+  auto text = five.map([](int i) { return std::to_string(i); });
+  static_assert(std::is_same<decltype(text), ma::Just_t<std::string>>::value,
+                "map keeps the presence");
+  ASSERT_EQ(text.get(), "5");
+  ASSERT_EQ(five.toRight(std::string("none")).asRight(), 5);
+
+  Maybe<int> maybe = five;
+  ASSERT_EQ(maybe, five);
+  ASSERT_NE(Maybe<int>(), five);
+  ASSERT_TRUE(five.filter([](int i) { return i > 5; }).isNothing());
+
+  static_assert(std::is_same<std::common_type_t<ma::Just_t<int>, ma::Nothing_t>,
+                             Maybe<int>>::value,
+                "Just_t and Nothing_t have Maybe as common type");
+  auto flatMapped = maybe.flatMap([](int i) { return Present(i + 1); });
+  static_assert(std::is_same<decltype(flatMapped), Maybe<int>>::value,
+                "Maybe::flatMap widens Just_t to Maybe");
+  ASSERT_EQ(flatMapped, Just(6));
+}
+
+TEST(Maybe, presentMove) {
+  auto nc = Present(NoCopy_t());
+  auto minusOne = std::move(nc).flatMap([](NoCopy_t&&) { return Present(-1); });
+  static_assert(std::is_same<decltype(minusOne), ma::Just_t<int>>::value,
+                "Just_t::flatMap returns the result of the function");
+  ASSERT_EQ(minusOne.get(), -1);
+
+  auto moved = Present(NoCopy_t());
+  auto right = std::move(moved).toRight(std::string("oops"));
+  ASSERT_FALSE(moved.get().hasBrains);
+  ASSERT_TRUE(right.asRight().hasBrains);
+
+  auto text = Present(std::string("hi"));
+  auto left = std::move(text).toLeft(0);
+  ASSERT_EQ(left.asLeft(), "hi");
+
+  auto ptr = Present(std::make_unique<int>(5));
+  ASSERT_EQ(*std::move(ptr).getOrElse(nullptr), 5);
+}
+
+TEST(Maybe, ifJust) {
+  Maybe<std::unique_ptr<int>> owned(std::make_unique<int>(3));
+  ASSERT_TRUE(owned.ifJust([](ma::Just_t<std::unique_ptr<int>&> p) {
+    *p.get() += 1;
+  }));
+  ASSERT_EQ(*owned.get(), 4);
+
+  std::unique_ptr<int> taken;
+  ASSERT_TRUE(std::move(owned).ifJust(
+      [&taken](ma::Just_t<std::unique_ptr<int>> p) {
+        taken = std::move(p.get());
+      }));
+  ASSERT_EQ(*taken, 4);
+
+  const Maybe<int> none;
+  ASSERT_FALSE(none.ifJust([](ma::Just_t<const int&>) { FAIL(); }));
+
+  int value = 1;
+  Maybe<int&> ref(value);
+  ASSERT_TRUE(ref.ifJust([](ma::Just_t<int&> i) { i.get() = 2; }));
+  ASSERT_EQ(value, 2);
+}
+
+TEST(Maybe, ordering) {
+  std::vector<Maybe<int>> values{Just(3), Nothing, Just(-1), Nothing};
+  std::sort(values.begin(), values.end());
+  ASSERT_EQ(values, (std::vector<Maybe<int>>{Nothing, Nothing, Just(-1),
+                                             Just(3)}));
+  ASSERT_LT(Maybe<int>(), Maybe<int>(-1));
+  ASSERT_LE(Maybe<int>(), Maybe<int>());
+  ASSERT_GT(Maybe<int>(2), Maybe<int>(1));
+  ASSERT_GE(Maybe<int>(2), Maybe<int>(2));
+  ASSERT_FALSE(Maybe<int>() < Maybe<int>());
+}
+
+TEST(Maybe, hash) {
+  std::unordered_map<Maybe<std::int64_t>, int> counts;
+  ++counts[Just<std::int64_t>(0)];
+  ++counts[Nothing];
+  ++counts[Just<std::int64_t>(0)];
+  ASSERT_EQ(counts.size(), 2u);
+  ASSERT_EQ(counts[Just<std::int64_t>(0)], 2);
+  ASSERT_EQ(counts[Nothing], 1);
+
+  /* Just(0) must not collide with Nothing by construction */
+  std::hash<Maybe<std::int64_t>> hash;
+  ASSERT_NE(hash(Just<std::int64_t>(0)), hash(Nothing));
+
+  std::string s = "key";
+  ASSERT_EQ(std::hash<Maybe<std::string&>>()(Maybe<std::string&>(s)),
+            std::hash<Maybe<std::string>>()(Just(s)));
+}
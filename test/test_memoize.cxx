@@ -0,0 +1,130 @@
+#include "marjoram/memoize.hpp"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using ma::Reader;
+
+namespace {
+struct Config {
+  std::string name;
+  std::uint64_t version = 0;
+
+  std::uint64_t generation() const { return version; }
+};
+
+using ConfigRef = std::reference_wrapper<const Config>;
+
+struct Plain {
+  int id;
+};
+}  // namespace
+
+TEST(memoize, cachesPerEnvironment) {
+  int runs = 0;
+  Reader<ConfigRef, std::string> greeting([&runs](const ConfigRef& c) {
+    runs++;
+    return "hello " + c.get().name;
+  });
+  auto cached = ma::memoize(greeting, 4);
+
+  Config a{"a"};
+  Config b{"b"};
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(cached.run(std::cref(a)), "hello a");
+  }
+  ASSERT_EQ(runs, 1);
+  ASSERT_EQ(cached.run(std::cref(b)), "hello b");
+  ASSERT_EQ(cached.run(std::cref(a)), "hello a");
+  ASSERT_EQ(runs, 2);
+}
+
+TEST(memoize, invalidatesOnGenerationChange) {
+  int runs = 0;
+  Reader<ConfigRef, std::string> name([&runs](const ConfigRef& c) {
+    runs++;
+    return c.get().name;
+  });
+  auto cached = ma::memoize(name.map([](std::string s) { return s + "!"; }), 4);
+
+  Config c{"x"};
+  ASSERT_EQ(cached.run(std::cref(c)), "x!");
+  c.name = "y";
+  ASSERT_EQ(cached.run(std::cref(c)), "x!");
+  c.version++;
+  ASSERT_EQ(cached.run(std::cref(c)), "y!");
+  ASSERT_EQ(cached.run(std::cref(c)), "y!");
+  ASSERT_EQ(runs, 2);
+}
+
+TEST(memoize, evictsLeastRecentlyUsed) {
+  int runs = 0;
+  Reader<const Config*, std::size_t> length([&runs](const Config* c) {
+    runs++;
+    return c->name.size();
+  });
+  auto cached = ma::memoize(length, 2);
+
+  Config a{"a"};
+  Config bb{"bb"};
+  Config ccc{"ccc"};
+  ASSERT_EQ(cached.run(&a), 1u);
+  ASSERT_EQ(cached.run(&bb), 2u);
+  ASSERT_EQ(cached.run(&a), 1u);
+  ASSERT_EQ(runs, 2);
+  /* evicts bb */
+  ASSERT_EQ(cached.run(&ccc), 3u);
+  ASSERT_EQ(cached.run(&a), 1u);
+  ASSERT_EQ(runs, 3);
+  ASSERT_EQ(cached.run(&bb), 2u);
+  ASSERT_EQ(runs, 4);
+}
+
+TEST(memoize, userKey) {
+  int runs = 0;
+  Reader<Plain, int> twice([&runs](const Plain& p) {
+    runs++;
+    return 2 * p.id;
+  });
+  auto cached = ma::memoize(twice, 8, [](const Plain& p) { return p.id; });
+  ASSERT_EQ(cached.run(Plain{3}), 6);
+  ASSERT_EQ(cached.run(Plain{3}), 6);
+  ASSERT_EQ(cached.run(Plain{4}), 8);
+  ASSERT_EQ(runs, 2);
+}
+
+TEST(memoize, references) {
+  Config c{"ref"};
+  Reader<ConfigRef, const std::string&> name(
+      [](const ConfigRef& r) -> const std::string& { return r.get().name; });
+  auto cached = ma::memoize(name, 1);
+  ASSERT_EQ(&cached.run(std::cref(c)), &c.name);
+  ASSERT_EQ(&cached.run(std::cref(c)), &c.name);
+}
+
+TEST(memoize, concurrentRuns) {
+  Reader<std::shared_ptr<const Config>, std::string> name(
+      [](const std::shared_ptr<const Config>& c) { return c->name; });
+  auto cached = ma::memoize(name, 2);
+  auto configs = std::vector<std::shared_ptr<const Config>>{
+      std::make_shared<Config>(Config{"a"}),
+      std::make_shared<Config>(Config{"b"}),
+      std::make_shared<Config>(Config{"c"})};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&cached, &configs]() {
+      for (int i = 0; i < 1000; ++i) {
+        const auto& c = configs[i % configs.size()];
+        ASSERT_EQ(cached.run(c), c->name);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
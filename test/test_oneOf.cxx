@@ -0,0 +1,93 @@
+#include "marjoram/oneOf.hpp"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+using ma::Alternative;
+using ma::Either;
+using ma::Left;
+using ma::OneOf;
+using ma::Right;
+
+namespace {
+template <int N> struct Message {
+  int payload;
+};
+}  // namespace
+
+TEST(OneOf, ctor) {
+  OneOf<int, std::string, double> number = 5;
+  ASSERT_EQ(number.index(), 0u);
+  ASSERT_TRUE(number.is<int>());
+  ASSERT_EQ(number.get<0>(), 5);
+
+  OneOf<int, std::string, double> text = std::string("text");
+  ASSERT_TRUE(text.is<1>());
+  ASSERT_EQ(text.get<std::string>(), "text");
+
+  OneOf<int, int> second(Alternative<1>(), 7);
+  ASSERT_TRUE(second.is<1>());
+
+  auto copy = text;
+  ASSERT_EQ(copy, text);
+  copy = number;
+  ASSERT_EQ(copy, number);
+  ASSERT_NE(copy, text);
+
+  OneOf<std::unique_ptr<int>, double> owned = std::make_unique<int>(3);
+  auto moved = std::move(owned);
+  ASSERT_EQ(*moved.get<0>(), 3);
+
+  static_assert(sizeof(OneOf<int, std::string, double>) <
+                    sizeof(Either<int, Either<std::string, double>>),
+                "single tag");
+}
+
+TEST(OneOf, visit) {
+  using Dispatch =
+      OneOf<Message<0>, Message<1>, Message<2>, Message<3>, Message<4>,
+            Message<5>, Message<6>, Message<7>, Message<8>, Message<9>,
+            Message<10>, Message<11>>;
+  static_assert(sizeof(Dispatch) == 2 * sizeof(int), "one byte tag");
+
+  Dispatch m(Alternative<9>(), Message<9>{4});
+  ASSERT_EQ(m.match([](const auto& msg) { return msg.payload; }), 4);
+
+  OneOf<int, std::string, double> text = std::string("four");
+  auto size = text.fold([](int) { return 0u; },
+                        [](const std::string& s) { return s.size(); },
+                        [](double) { return 1u; });
+  ASSERT_EQ(size, 4u);
+  text.match([](auto& t) -> void { t = t + t; });
+  ASSERT_EQ(text.get<std::string>(), "fourfour");
+}
+
+TEST(OneOf, map) {
+  OneOf<int, std::string> text = std::string("text");
+  auto size = text.map<std::string>([](const std::string& s) {
+    return s.size();
+  });
+  static_assert(std::is_same<decltype(size), OneOf<int, std::size_t>>::value,
+                "map replaces the alternative");
+  ASSERT_EQ(size.get<1>(), 4u);
+
+  OneOf<int, std::string> number = 3;
+  auto same = std::move(number).mapAt<1>([](std::string s) { return s; });
+  ASSERT_EQ(same.get<0>(), 3);
+}
+
+TEST(OneOf, either) {
+  using Three = OneOf<int, std::string, double>;
+  Three text = std::string("text");
+  Either<int, Either<std::string, double>> nested = text.toEither();
+  ASSERT_EQ(nested.asRight().asLeft(), "text");
+  ASSERT_EQ(Three::fromEither(nested), text);
+
+  Three real = 2.5;
+  ASSERT_EQ(real.toEither().asRight().asRight(), 2.5);
+  ASSERT_EQ(Three::fromEither(real.toEither()), real);
+  ASSERT_EQ(Three::fromEither({Left, 1}).get<int>(), 1);
+
+  OneOf<int, double> two = 1.5;
+  ASSERT_EQ(two.toEither(), (Either<int, double>(Right, 1.5)));
+}
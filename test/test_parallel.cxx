@@ -0,0 +1,288 @@
+#include "marjoram/parallel.hpp"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using ma::CancellationToken;
+using ma::Either;
+using ma::Left;
+using ma::Right;
+using ma::WorkStealingPool;
+
+namespace {
+using Result = Either<std::string, int>;
+
+Result right(int i) { return Result(Right, i); }
+}  // namespace
+
+TEST(WorkStealingPool, runsEverything) {
+  std::atomic<int> count(0);
+  {
+    WorkStealingPool pool(3);
+    ASSERT_EQ(pool.size(), 3u);
+    for (int i = 0; i < 100; ++i) {
+      pool.execute([&count, &pool]() {
+        count++;
+        /* submitted from a worker, to its own queue */
+        pool.execute([&count]() { count++; });
+      });
+    }
+  }
+  ASSERT_EQ(count, 200);
+}
+
+TEST(WorkStealingPool, callersHelp) {
+  WorkStealingPool pool(1);
+  std::atomic<bool> started(false);
+  std::atomic<bool> release(false);
+  pool.execute([&started, &release]() {
+    started = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  while (!started) {
+    std::this_thread::yield();
+  }
+  int ran = 0;
+  pool.execute([&ran]() { ran++; });
+  ASSERT_TRUE(pool.tryRunOne());
+  ASSERT_EQ(ran, 1);
+  ASSERT_FALSE(pool.tryRunOne());
+  release = true;
+}
+
+TEST(parZip, combinesResults) {
+  WorkStealingPool pool(2);
+  auto r = ma::parZip(pool, []() { return right(1); },
+                      []() { return Either<std::string, double>(Right, 2.5); },
+                      []() {
+                        return Either<std::string, std::string>(Right, "three");
+                      });
+  ASSERT_EQ(r.asRight(), std::make_tuple(1, 2.5, std::string("three")));
+}
+
+TEST(parZip, sharedPool) {
+  auto r = ma::parZip([]() { return right(1); }, []() { return right(2); });
+  ASSERT_EQ(r.asRight(), std::make_tuple(1, 2));
+}
+
+TEST(parZip, moveOnlyResults) {
+  WorkStealingPool pool(2);
+  using Ptr = std::unique_ptr<int>;
+  auto r = ma::parZip(pool,
+                      []() {
+                        return Either<std::string, Ptr>(Right, new int(1));
+                      },
+                      []() {
+                        return Either<std::string, Ptr>(Right, new int(2));
+                      });
+  ASSERT_EQ(*std::get<1>(r.asRight()), 2);
+}
+
+TEST(parZip, firstErrorCancels) {
+  WorkStealingPool pool(2);
+  std::atomic<bool> observed(false);
+  auto r = ma::parZip(
+      pool,
+      [](const CancellationToken&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return Result(Left, "failed");
+      },
+      [&observed](const CancellationToken& token) {
+        while (!token.isCancelled()) {
+          std::this_thread::yield();
+        }
+        observed = true;
+        return right(2);
+      });
+  ASSERT_EQ(r.asLeft(), "failed");
+  ASSERT_TRUE(observed);
+}
+
+TEST(parZip, cancelledFunctionsAreSkipped) {
+  WorkStealingPool pool(1);
+  std::atomic<bool> busy(false);
+  std::atomic<bool> release(false);
+  pool.execute([&busy, &release]() {
+    busy = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  while (!busy) {
+    std::this_thread::yield();
+  }
+  int started = 0;
+  auto r = ma::parZip(
+      pool,
+      [&release]() {
+        release = true;
+        return Result(Left, "failed");
+      },
+      [&started]() {
+        started++;
+        return right(2);
+      });
+  ASSERT_TRUE(r.isLeft());
+  ASSERT_EQ(started, 0);
+}
+
+TEST(parZip, nested) {
+  WorkStealingPool pool(1);
+  auto sum = [&pool](int base) {
+    auto r = ma::parZip(pool, [base]() { return right(base); },
+                        [base]() { return right(base + 1); });
+    return right(std::get<0>(r.asRight()) + std::get<1>(r.asRight()));
+  };
+  auto r = ma::parZip(pool, [&sum]() { return sum(0); },
+                      [&sum]() { return sum(10); },
+                      [&sum]() { return sum(20); });
+  ASSERT_EQ(r.asRight(), std::make_tuple(1, 21, 41));
+}
+
+TEST(parZip, exceptionWaitsForOthers) {
+  WorkStealingPool pool(2);
+  std::atomic<bool> started(false);
+  std::atomic<bool> finished(false);
+  auto run = [&]() {
+    return ma::parZip(
+        pool, []() -> Result { throw std::runtime_error("boom"); },
+        [&started, &finished](const CancellationToken& token) {
+          started = true;
+          while (!token.isCancelled()) {
+            std::this_thread::yield();
+          }
+          finished = true;
+          return right(2);
+        });
+  };
+  ASSERT_THROW(run(), std::runtime_error);
+  ASSERT_EQ(started, finished);
+}
+
+TEST(parZip, laterExceptionCancelsAndRethrows) {
+  WorkStealingPool pool(1);
+  std::atomic<bool> started(false);
+  std::atomic<bool> finished(false);
+  auto run = [&]() {
+    return ma::parZip(
+        pool,
+        [&started, &finished](const CancellationToken& token) {
+          started = true;
+          while (!token.isCancelled()) {
+            std::this_thread::yield();
+          }
+          finished = true;
+          return right(1);
+        },
+        []() -> Result { throw std::runtime_error("boom"); });
+  };
+  ASSERT_THROW(run(), std::runtime_error);
+  ASSERT_EQ(started, finished);
+}
+
+TEST(parZip, exceptionOnHelpingCaller) {
+  WorkStealingPool pool(1);
+  std::atomic<bool> busy(false);
+  std::atomic<bool> release(false);
+  pool.execute([&busy, &release]() {
+    busy = true;
+    while (!release) {
+      std::this_thread::yield();
+    }
+  });
+  while (!busy) {
+    std::this_thread::yield();
+  }
+  /* the worker is busy, the caller runs the throwing function itself */
+  auto run = [&]() {
+    return ma::parZip(
+        pool, []() { return right(1); },
+        []() -> Result { throw std::runtime_error("boom"); });
+  };
+  EXPECT_THROW(run(), std::runtime_error);
+  release = true;
+}
+
+namespace {
+struct Directory {
+  std::vector<std::string> names;
+  std::vector<int> ages;
+};
+
+using ma::Reader;
+
+/* as in test_reader.cxx, to refer into the environment */
+using DirectoryRef = std::reference_wrapper<const Directory>;
+
+Reader<DirectoryRef, const std::string&> name(std::size_t i) {
+  return Reader<DirectoryRef, const std::string&>(
+      [i](const DirectoryRef& d) -> const std::string& {
+        return d.get().names[i];
+      });
+}
+
+Reader<DirectoryRef, std::thread::id> threadId() {
+  return Reader<DirectoryRef, std::thread::id>(
+      [](const DirectoryRef&) { return std::this_thread::get_id(); });
+}
+}  // namespace
+
+TEST(parReader, parallel) {
+  WorkStealingPool pool(2);
+  ma::ParReaderOptions options;
+  options.pool = &pool;
+  options.inlineBelow = std::chrono::nanoseconds(0);
+
+  Reader<DirectoryRef, int> oldest([](const DirectoryRef& d) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    int max = 0;
+    for (int a : d.get().ages) {
+      max = std::max(max, a);
+    }
+    return max;
+  });
+  auto both = ma::parReader(options, name(1), oldest);
+
+  const Directory d{{"ann", "bob"}, {31, 42}};
+  for (int i = 0; i < 10; ++i) {
+    auto r = both.run(std::cref(d));
+    ASSERT_EQ(std::get<0>(r), "bob");
+    ASSERT_EQ(std::get<1>(r), 42);
+  }
+}
+
+TEST(parReader, cheapReadersRunInline) {
+  WorkStealingPool pool(2);
+  ma::ParReaderOptions options;
+  options.pool = &pool;
+  options.inlineBelow = std::chrono::hours(1);
+
+  auto ids = ma::parReader(options, threadId(), threadId(), threadId());
+  const Directory d;
+  for (int i = 0; i < 10; ++i) {
+    auto r = ids.run(std::cref(d));
+    ASSERT_EQ(std::get<0>(r), std::this_thread::get_id());
+    ASSERT_EQ(std::get<1>(r), std::this_thread::get_id());
+    ASSERT_EQ(std::get<2>(r), std::this_thread::get_id());
+  }
+}
+
+TEST(parReader, rethrows) {
+  ma::ParReaderOptions options;
+  options.inlineBelow = std::chrono::nanoseconds(0);
+  Reader<DirectoryRef, int> failing(
+      [](const DirectoryRef&) -> int { throw std::runtime_error("boom"); });
+  auto r = ma::parReader(options, threadId(), failing);
+  const Directory d;
+  ASSERT_THROW(r.run(std::cref(d)), std::runtime_error);
+}
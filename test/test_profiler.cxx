@@ -0,0 +1,164 @@
+#include "marjoram/lazy.hpp"
+#include "gtest/gtest.h"
+#include <sstream>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef MARJORAM_PROFILE_LAZY
+#error "test_profiler.cxx must be compiled with MARJORAM_PROFILE_LAZY"
+#endif
+
+using ma::Lazy;
+
+TEST(Profiler, collapsedStacks) {
+  ma::profiler::reset();
+  Lazy<int> five([]() { return 5; });
+  five.labeled(MARJORAM_LAZY_LABEL("five"));
+  Lazy<int> ten =
+      five.map([](int i) { return 2 * i; }).labeled(MARJORAM_LAZY_LABEL("ten"));
+  ASSERT_EQ(ten.get(), 10);
+  /* evaluated nodes are not recorded again */
+  ASSERT_EQ(ten.get(), 10);
+
+  std::ostringstream os;
+  ma::profiler::writeCollapsedStacks(os);
+  const std::string stacks = os.str();
+  EXPECT_NE(stacks.find("ten "), std::string::npos) << stacks;
+  EXPECT_NE(stacks.find("ten;five "), std::string::npos) << stacks;
+  EXPECT_EQ(stacks.find("five;ten"), std::string::npos) << stacks;
+}
+
+TEST(Profiler, defaultLabels) {
+  ma::profiler::reset();
+  Lazy<int> five([]() { return 5; });
+  Lazy<int> ten = five.flatMap(
+      [](int i) { return Lazy<int>([i]() { return 2 * i; }); });
+  ASSERT_EQ(ten.get(), 10);
+
+  std::ostringstream os;
+  ma::profiler::writeCollapsedStacks(os);
+  const std::string stacks = os.str();
+  EXPECT_NE(stacks.find("flatMap;Lazy "), std::string::npos) << stacks;
+}
+
+TEST(Profiler, callerLocation) {
+  ma::profiler::reset();
+  Lazy<int> five([]() { return 5; });
+  const int line = __LINE__ + 1;
+  Lazy<int> ten = five.map([](int i) { return 2 * i; });
+  ASSERT_EQ(ten.get(), 10);
+
+  std::ostringstream os;
+  ma::profiler::writeChromeTrace(os);
+  const std::string trace = os.str();
+#ifdef MARJORAM_HAS_BUILTIN_LOCATION
+  EXPECT_NE(trace.find("\"line\":" + std::to_string(line) + ','),
+            std::string::npos)
+      << trace;
+#else
+  (void)line;
+#endif
+  EXPECT_NE(trace.find("\"name\":\"map\""), std::string::npos) << trace;
+}
+
+TEST(Profiler, chromeTrace) {
+  ma::profiler::reset();
+  Lazy<int> five([]() { return 5; });
+  five.labeled(MARJORAM_LAZY_LABEL("\"five\""));
+  std::thread([&five]() { five.get(); }).join();
+
+  std::ostringstream os;
+  ma::profiler::writeChromeTrace(os);
+  const std::string trace = os.str();
+  EXPECT_EQ(trace.find("{\"traceEvents\":["), 0u);
+  EXPECT_NE(trace.find("\"name\":\"\\\"five\\\"\""), std::string::npos)
+      << trace;
+  EXPECT_NE(trace.find("\"ph\":\"X\""), std::string::npos) << trace;
+  EXPECT_NE(trace.find("test_profiler.cxx"), std::string::npos) << trace;
+}
+
+TEST(Profiler, reset) {
+  Lazy<int> five([]() { return 5; });
+  five.labeled(MARJORAM_LAZY_LABEL("five"));
+  five.get();
+  ma::profiler::reset();
+
+  std::ostringstream os;
+  ma::profiler::writeCollapsedStacks(os);
+  EXPECT_EQ(os.str(), "");
+}
+
+TEST(Profiler, resetWhileEvaluating) {
+  ma::profiler::reset();
+  /* enough events to span several chunks */
+  for (int i = 0; i < 600; ++i) {
+    Lazy<int>([]() { return 0; }).get();
+  }
+  Lazy<int> inner([]() { return 5; });
+  inner.labeled(MARJORAM_LAZY_LABEL("inner"));
+  Lazy<int> outer([&inner]() {
+    ma::profiler::reset();
+    return inner.get();
+  });
+  outer.labeled(MARJORAM_LAZY_LABEL("outer"));
+  ASSERT_EQ(outer.get(), 5);
+  Lazy<int> after([]() { return 6; });
+  after.labeled(MARJORAM_LAZY_LABEL("after"));
+  ASSERT_EQ(after.get(), 6);
+
+  std::ostringstream os;
+  ma::profiler::writeCollapsedStacks(os);
+  const std::string stacks = os.str();
+  EXPECT_EQ(stacks.find("outer"), std::string::npos) << stacks;
+  EXPECT_NE(stacks.find("inner "), std::string::npos) << stacks;
+  EXPECT_NE(stacks.find("after "), std::string::npos) << stacks;
+  EXPECT_EQ(stacks.find("Lazy"), std::string::npos) << stacks;
+}
+
+TEST(Profiler, threadBuffersReleased) {
+  ma::profiler::reset();
+  auto& registry = ma::profiler::detail::registry();
+  for (int i = 0; i < 10; ++i) {
+    std::thread([]() { Lazy<int>([]() { return 5; }).get(); }).join();
+  }
+  /* exited threads hand their buffer over, events are kept until reset */
+  EXPECT_EQ(registry.idle.size(), 1u);
+  std::ostringstream os;
+  ma::profiler::writeChromeTrace(os);
+  const std::string trace = os.str();
+  std::size_t events = 0;
+  for (auto i = trace.find("\"ph\""); i != std::string::npos;
+       i = trace.find("\"ph\"", i + 1)) {
+    events++;
+  }
+  EXPECT_EQ(events, 10u) << trace;
+  ma::profiler::reset();
+  EXPECT_TRUE(registry.idle.empty());
+}
+
+TEST(Profiler, concurrentExport) {
+  ma::profiler::reset();
+  std::atomic<int> running(4);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&running]() {
+      for (int i = 0; i < 2000; ++i) {
+        Lazy<int> five([]() { return 5; });
+        five.map([](int j) { return 2 * j; }).get();
+      }
+      running--;
+    });
+  }
+  for (int i = 0; running > 0; ++i) {
+    std::ostringstream os;
+    ma::profiler::writeChromeTrace(os);
+    if (i % 4 == 0) {
+      ma::profiler::reset();
+    }
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
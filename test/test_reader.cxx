@@ -114,3 +114,65 @@ TEST(Reader, DependencyInjection) {
   ASSERT_EQ(johndata["email"], "john.doe@acme.corp");
   ASSERT_EQ(johndata["boss"], "John Doe");
 }
+
+/**
+ * Components depending on parts of a larger environment, which must not be
+ * copied.
+ */
+
+struct Counted {
+  Counted() = default;
+  Counted(const Counted&) { copies++; }
+  static int copies;
+};
+int Counted::copies = 0;
+
+struct Database : Counted {
+  int rows = 3;
+};
+
+struct Settings : Counted {
+  std::string prefix = "rows: ";
+};
+
+struct Services : Counted {
+  Database database;
+  Settings settings;
+};
+
+static Reader<Database, int> countRows() {
+  return Reader<Database, int>([](const Database& db) { return db.rows; });
+}
+
+static Reader<Settings, std::string> describe(int rows) {
+  return Reader<Settings, std::string>(
+      [rows](const Settings& s) { return s.prefix + std::to_string(rows); });
+}
+
+TEST(Reader, local) {
+  Reader<Services, std::string> report =
+      countRows()
+          .local<Services>(
+              [](const Services& s) -> const Database& { return s.database; })
+          .flatMap([](int rows) {
+            return describe(rows).local<Services>(
+                [](const Services& s) -> const Settings& {
+                  return s.settings;
+                });
+          });
+
+  Services services;
+  Counted::copies = 0;
+  ASSERT_EQ(report.run(services), "rows: 3");
+  ASSERT_EQ(report.map([](const std::string& s) { return s.size(); })
+                .run(services),
+            7u);
+  ASSERT_EQ(Counted::copies, 0);
+}
+
+TEST(Reader, localView) {
+  Reader<int, double> sqrter([](int a) { return std::sqrt(a); });
+  Reader<std::string, double> sqrtOfLength =
+      sqrter.local<std::string>([](const std::string& s) { return s.size(); });
+  ASSERT_FLOAT_EQ(sqrtOfLength.run("abcd"), 2.0);
+}
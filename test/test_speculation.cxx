@@ -0,0 +1,134 @@
+#include "marjoram/speculation.hpp"
+#include "gtest/gtest.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using ma::SharedLazy;
+using ma::SpeculationOptions;
+using ma::Speculator;
+
+namespace {
+/* polls `pred` for up to a few seconds */
+template <typename Pred> bool eventually(Pred pred) {
+  for (int i = 0; i < 500; ++i) {
+    if (pred()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return pred();
+}
+
+SpeculationOptions idle() {
+  SpeculationOptions options;
+  options.loadProbe = []() { return 0.0; };
+  options.backoff = std::chrono::milliseconds(1);
+  return options;
+}
+}  // namespace
+
+TEST(SharedLazy, evaluatesOnce) {
+  std::atomic<int> evalCount(0);
+  SharedLazy<int> five([&evalCount]() {
+    evalCount++;
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    return 5;
+  });
+  const SharedLazy<int> copy = five;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&copy]() { ASSERT_EQ(copy.get(), 5); });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  ASSERT_EQ(evalCount, 1);
+  ASSERT_TRUE(five.isEvaluated());
+}
+
+TEST(SharedLazy, retriesAfterException) {
+  int evalCount = 0;
+  SharedLazy<int> flaky([&evalCount]() {
+    if (evalCount++ == 0) {
+      throw std::runtime_error("flaky");
+    }
+    return 5;
+  });
+  ASSERT_THROW(flaky.get(), std::runtime_error);
+  ASSERT_FALSE(flaky.isEvaluated());
+  ASSERT_EQ(flaky.get(), 5);
+  ASSERT_EQ(evalCount, 2);
+}
+
+TEST(Speculator, evaluatesAheadOfDemand) {
+  std::atomic<int> evalCount(0);
+  SharedLazy<int> five([&evalCount]() {
+    evalCount++;
+    return 5;
+  });
+  Speculator speculator(idle());
+  speculator.speculate(five);
+  ASSERT_TRUE(eventually([&five]() { return five.isEvaluated(); }));
+  ASSERT_EQ(five.get(), 5);
+  ASSERT_EQ(evalCount, 1);
+}
+
+TEST(Speculator, priorityOrder) {
+  std::atomic<bool> busy(true);
+  SpeculationOptions options = idle();
+  options.loadProbe = [&busy]() { return busy ? 1.0 : 0.0; };
+  Speculator speculator(options);
+
+  std::mutex mutex;
+  std::vector<int> order;
+  auto record = [&](int i) {
+    return SharedLazy<int>([&mutex, &order, i]() {
+      std::lock_guard<std::mutex> lock(mutex);
+      order.push_back(i);
+      return i;
+    });
+  };
+  auto low = record(0);
+  auto expensive = record(1);
+  auto cheap = record(2);
+  speculator.speculate(low, 0);
+  speculator.speculate(expensive, 1, 100);
+  speculator.speculate(cheap, 1, 1);
+
+  /* throttled while busy */
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_FALSE(low.isEvaluated());
+  busy = false;
+
+  ASSERT_TRUE(eventually([&low]() { return low.isEvaluated(); }));
+  std::lock_guard<std::mutex> lock(mutex);
+  ASSERT_EQ(order, (std::vector<int>{2, 1, 0}));
+}
+
+TEST(Speculator, demandIsNotDelayed) {
+  SpeculationOptions options = idle();
+  options.maxLoad = -1;  // never speculate
+  Speculator speculator(options);
+  SharedLazy<int> five([]() { return 5; });
+  speculator.speculate(five);
+  ASSERT_EQ(five.get(), 5);
+  ASSERT_EQ(speculator.pending(), 1u);
+}
+
+TEST(Speculator, dropsUnreferenced) {
+  std::atomic<int> evalCount(0);
+  {
+    Speculator speculator(idle());
+    {
+      SharedLazy<int> five([&evalCount]() { return ++evalCount; });
+      speculator.speculate(five, 0);
+    }
+    ASSERT_TRUE(
+        eventually([&speculator]() { return speculator.pending() == 0; }));
+  }
+  ASSERT_EQ(evalCount, 0);
+}
@@ -0,0 +1,99 @@
+#include "marjoram/state.hpp"
+#include "gtest/gtest.h"
+#include <map>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using ma::Unit;
+
+namespace {
+/* vector counting its copies */
+struct Particles {
+  Particles() = default;
+  Particles(const Particles& other) : positions(other.positions) { copies++; }
+  Particles(Particles&&) = default;
+  Particles& operator=(const Particles& other) {
+    positions = other.positions;
+    copies++;
+    return *this;
+  }
+
+  std::vector<double> positions;
+  static int copies;
+};
+int Particles::copies = 0;
+
+auto advance(double dt) {
+  return ma::modify<Particles>([dt](Particles& ps) {
+    for (auto& p : ps.positions) {
+      p += dt;
+    }
+  });
+}
+
+auto total() {
+  return ma::gets<Particles>([](const Particles& ps) {
+    return std::accumulate(ps.positions.begin(), ps.positions.end(), 0.0);
+  });
+}
+
+auto spawn(double at) {
+  return ma::state<Particles>([at](Particles& ps) {
+    ps.positions.push_back(at);
+    return ps.positions.size();
+  });
+}
+}  // namespace
+
+TEST(State, runsInPlace) {
+  auto simulation = spawn(0).flatMap([](std::size_t) { return spawn(10); })
+                        .flatMap([](std::size_t n) {
+                          return advance(0.5).repeat(n == 1002 ? 10 : 0);
+                        })
+                        .flatMap([](Unit) { return total(); });
+
+  Particles ps;
+  ps.positions.resize(1000, 1.0);
+  Particles::copies = 0;
+  auto result = simulation.run(std::move(ps));
+  ASSERT_DOUBLE_EQ(result.first, 1000 * 6.0 + 5.0 + 15.0);
+  ASSERT_EQ(result.second.positions.size(), 1002u);
+  ASSERT_EQ(Particles::copies, 0);
+
+  /* lvalues are copied once, by the caller */
+  ASSERT_DOUBLE_EQ(total().eval(result.second), result.first);
+  ASSERT_EQ(Particles::copies, 1);
+  simulation.apply(result.second);
+  ASSERT_EQ(Particles::copies, 1);
+  ASSERT_EQ(result.second.positions.size(), 1004u);
+}
+
+TEST(State, mapAndPure) {
+  using Counter = std::map<std::string, int>;
+  auto count = [](std::string word) {
+    return ma::state<Counter>(
+        [word](Counter& c) -> int& { return ++c[word]; });
+  };
+  auto counted = count("a")
+                     .flatMap([&](int) { return count("b"); })
+                     .flatMap([&](int) { return count("a"); })
+                     .map([](int n) { return std::to_string(n); });
+  auto result = counted.run(Counter());
+  ASSERT_EQ(result.first, "2");
+  ASSERT_EQ(result.second, (Counter{{"a", 2}, {"b", 1}}));
+
+  ASSERT_EQ(ma::pure<Counter>(3).eval(Counter()), 3);
+  ASSERT_EQ(counted.exec(Counter{{"b", 5}}),
+            (Counter{{"a", 2}, {"b", 6}}));
+}
+
+TEST(State, composesStatically) {
+  auto s = advance(1).flatMap([](Unit) { return total(); });
+  static_assert(std::is_trivially_copyable<decltype(s)>::value, "");
+  static_assert(std::is_same<decltype(s)::value_type, double>::value, "");
+  Particles ps;
+  ps.positions = {1, 2};
+  ASSERT_DOUBLE_EQ(s.apply(ps), 5.0);
+}
@@ -0,0 +1,126 @@
+#include "marjoram/task.hpp"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using ma::Either;
+using ma::Left;
+using ma::Promise;
+using ma::Right;
+using ma::Task;
+using ma::ThreadPool;
+
+TEST(Task, mapInline) {
+  Promise<std::string, int> promise;
+  Task<std::string, double> half =
+      promise.getTask().map([](int i) { return i / 2.0; });
+  ASSERT_FALSE(half.isReady());
+  promise.setValue(5);
+  ASSERT_TRUE(half.isReady());
+  ASSERT_EQ(std::move(half).get(), (Either<std::string, double>(Right, 2.5)));
+}
+
+TEST(Task, alreadyCompleted) {
+  auto five = ma::makeTask(Either<std::string, int>(Right, 5));
+  ASSERT_TRUE(five.isReady());
+  auto ten = std::move(five).map([](int i) { return 2 * i; });
+  ASSERT_TRUE(ten.isReady());
+  ASSERT_EQ(std::move(ten).get().asRight(), 10);
+}
+
+TEST(Task, flatMapAndErrors) {
+  ThreadPool pool(2);
+  auto parse = [&pool](std::string s) {
+    return ma::async(pool, [s]() {
+      if (s.empty()) {
+        return Either<std::string, int>(Left, "empty");
+      }
+      return Either<std::string, int>(Right, static_cast<int>(s.size()));
+    });
+  };
+  auto ok = ma::async(pool, []() {
+              return Either<std::string, std::string>(Right, "four");
+            }).flatMap(parse);
+  ASSERT_EQ(std::move(ok).get().asRight(), 4);
+
+  auto failed = ma::async(pool, []() {
+                  return Either<std::string, std::string>(Right, "");
+                }).flatMap(parse);
+  ASSERT_EQ(std::move(failed).get().asLeft(), "empty");
+}
+
+TEST(Task, leftMapRecover) {
+  Promise<int, std::string> promise;
+  auto described =
+      promise.getTask().leftMap([](int code) { return std::to_string(code); });
+  auto recovered = std::move(described).recover(
+      [](std::string e) { return "recovered from " + e; });
+  promise.setError(404);
+  auto result = std::move(recovered).get();
+  ASSERT_TRUE(result.isRight());
+  ASSERT_EQ(result.asRight(), "recovered from 404");
+}
+
+TEST(Task, via) {
+  ThreadPool pool(1);
+  Promise<std::string, int> promise;
+  std::thread::id ranOn;
+  auto task = promise.getTask().via(pool).map([&ranOn](int i) {
+    ranOn = std::this_thread::get_id();
+    return i;
+  });
+  promise.setValue(5);
+  ASSERT_EQ(std::move(task).get().asRight(), 5);
+  ASSERT_NE(ranOn, std::this_thread::get_id());
+}
+
+TEST(Task, moveOnly) {
+  Promise<std::string, std::unique_ptr<int>> promise;
+  auto task = promise.getTask().map(
+      [](std::unique_ptr<int> p) { return std::make_unique<int>(*p * 2); });
+  promise.setValue(std::make_unique<int>(21));
+  ASSERT_EQ(*std::move(task).get().asRight(), 42);
+}
+
+TEST(Task, whenAll) {
+  ThreadPool pool(4);
+  auto five = ma::async(pool, []() { return Either<std::string, int>(5); });
+  auto hi = ma::async(
+      pool, []() { return Either<std::string, std::string>(Right, "hi"); });
+  auto both = ma::whenAll(std::move(five), std::move(hi));
+  ASSERT_EQ(std::move(both).get().asRight(), std::make_tuple(5, "hi"));
+
+  std::vector<Task<std::string, int>> tasks;
+  for (int i = 0; i < 100; ++i) {
+    tasks.push_back(
+        ma::async(pool, [i]() { return Either<std::string, int>(i); }));
+  }
+  auto all = ma::whenAll(std::move(tasks));
+  auto values = std::move(all).get().asRight();
+  ASSERT_EQ(values.size(), 100u);
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_EQ(values[i], i);
+  }
+
+  Promise<std::string, int> never;
+  auto failing = ma::whenAll(
+      never.getTask(),
+      ma::makeTask(Either<std::string, double>(Left, "failed")));
+  ASSERT_EQ(std::move(failing).get().asLeft(), "failed");
+  never.setValue(0);
+}
+
+TEST(Task, whenAny) {
+  Promise<std::string, int> slow;
+  Promise<std::string, int> fast;
+  std::vector<Task<std::string, int>> tasks;
+  tasks.push_back(slow.getTask());
+  tasks.push_back(fast.getTask());
+  auto first = ma::whenAny(std::move(tasks));
+  fast.setValue(1);
+  slow.setValue(2);
+  ASSERT_EQ(std::move(first).get().asRight(), 1);
+}
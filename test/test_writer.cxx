@@ -0,0 +1,127 @@
+#include "marjoram/writer.hpp"
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <vector>
+
+using ma::Either;
+using ma::Log;
+using ma::LogStream;
+using ma::Streamed;
+using ma::Writer;
+
+namespace {
+using Logged = Writer<std::string, int>;
+
+Logged half(int i) {
+  return Logged(i / 2).tell("halved " + std::to_string(i));
+}
+
+using Checked = Writer<std::string, Either<std::string, int>>;
+
+Checked checkedHalf(int i) {
+  if (i % 2) {
+    return Checked(Either<std::string, int>(ma::Left, "odd"))
+        .tell("refused " + std::to_string(i));
+  }
+  return Checked(Either<std::string, int>(ma::Right, i / 2))
+      .tell("halved " + std::to_string(i));
+}
+}  // namespace
+
+TEST(Log, appendAndConcat) {
+  Log<int> empty;
+  ASSERT_TRUE(empty.empty());
+  Log<int> a{1, 2};
+  Log<int> b = a.append(3);
+  Log<int> c = b.concat(Log<int>{4, 5}).append(6);
+  /* persistent */
+  ASSERT_EQ(a.toVector(), (std::vector<int>{1, 2}));
+  ASSERT_EQ(b.toVector(), (std::vector<int>{1, 2, 3}));
+  ASSERT_EQ(c.toVector(), (std::vector<int>{1, 2, 3, 4, 5, 6}));
+  ASSERT_EQ(c.size(), 6u);
+  ASSERT_EQ(empty.concat(a).toVector(), a.toVector());
+}
+
+TEST(Log, longChains) {
+  Log<int> log;
+  for (int i = 0; i < 200000; ++i) {
+    log = log.concat(Log<int>{i});
+  }
+  ASSERT_EQ(log.size(), 200000u);
+  int expected = 0;
+  bool ordered = true;
+  log.forEach([&](int i) { ordered = ordered && i == expected++; });
+  ASSERT_TRUE(ordered);
+}
+
+TEST(Writer, mapAndFlatMap) {
+  auto w = half(40).flatMap(half).map([](int i) { return i + 1; }).flatMap(
+      [](int i) { return half(i).tell("done"); });
+  ASSERT_EQ(w.value(), 5);
+  ASSERT_EQ(w.log().toVector(),
+            (std::vector<std::string>{"halved 40", "halved 20", "halved 11",
+                                      "done"}));
+}
+
+TEST(Writer, loop) {
+  Logged w(0);
+  for (int i = 0; i < 100000; ++i) {
+    w = std::move(w).flatMap(
+        [](int n) { return Logged(n + 1).tell(std::to_string(n)); });
+  }
+  ASSERT_EQ(w.value(), 100000);
+  ASSERT_EQ(w.log().size(), 100000u);
+  ASSERT_EQ(w.log().toVector()[99999], "99999");
+}
+
+TEST(Writer, either) {
+  auto ok = checkedHalf(12).flatMapRight(checkedHalf).mapRight(
+      [](int i) { return std::to_string(i); });
+  ASSERT_EQ(ok.value().asRight(), "3");
+  ASSERT_EQ(ok.log().toVector(),
+            (std::vector<std::string>{"halved 12", "halved 6"}));
+
+  auto failed = checkedHalf(6).flatMapRight(checkedHalf).flatMapRight(
+      checkedHalf);
+  ASSERT_EQ(failed.value().asLeft(), "odd");
+  /* keeps the log up to the failure */
+  ASSERT_EQ(failed.log().toVector(),
+            (std::vector<std::string>{"halved 6", "refused 3"}));
+}
+
+TEST(Writer, streamed) {
+  using Traced = Writer<Streamed<int>, int>;
+  LogStream<int>::drain([](int) {});
+  const auto dropped = LogStream<int>::dropped();
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([t]() {
+      Traced w(0);
+      for (int i = 0; i < 1000; ++i) {
+        w = w.flatMap([t](int n) { return Traced(n + 1).tell(t * 1000 + n); });
+      }
+      ASSERT_EQ(w.value(), 1000);
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  std::vector<int> last(4, -1);
+  bool ordered = true;
+  auto n = LogStream<int>::drain([&](int e) {
+    ordered = ordered && e % 1000 == last[e / 1000] + 1;
+    last[e / 1000] = e % 1000;
+  });
+  ASSERT_EQ(n, 4000u);
+  ASSERT_TRUE(ordered);
+  ASSERT_EQ(LogStream<int>::dropped(), dropped);
+
+  /* full rings drop */
+  for (std::size_t i = 0; i < LogStream<int>::capacity + 3; ++i) {
+    Traced(0).tell(1);
+  }
+  ASSERT_EQ(LogStream<int>::drain([](int) {}), LogStream<int>::capacity);
+  ASSERT_EQ(LogStream<int>::dropped(), dropped + 3);
+}